@@ -0,0 +1,203 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cmath>
+#include <variant>
+#include <vector>
+#include <sampling/BinaryTree.hpp>
+#include <sampling/DynamicProposalArray.hpp>
+#include <sampling/LogCascade.hpp>
+#include <sampling/Sampler.hpp>
+
+namespace sampling {
+
+// Dynamic sampler on top of a DynamicProposalArray, a LogCascade or an 8-ary tree that moves to another of them when
+// the workload drifts. It counts samples and updates and, once per window of max(2n, 2^16) operations, estimates the
+// cost per operation of every backend from the update share, the mean weight change relative to the average weight
+// and n. It rebuilds on the cheapest one if that saves a quarter and the savings over the next window outweigh the
+// rebuild. The cascade is only considered while the largest weight fits its partitions. A window has at least n
+// operations, so the rebuilds take amortized constant time per operation; the counts are halved after each window to
+// follow drift. Weights are double only, as the cost model was measured on double backends.
+class AdaptiveSampler {
+    using Backends = std::variant<DynamicProposalArray<>, LogCascade<1>, BinaryTree<8>>;
+public:
+    enum class Backend { ProposalArray, LogCascade, Tree }; // in the order of Backends
+
+    struct Stats {
+        size_t n;
+        double update_share; // updates, pushes and pops among all operations
+        double update_size; // mean absolute weight change per update relative to the average weight
+        double max; // largest weight
+        double spread; // max / avg of the weights
+    };
+
+    AdaptiveSampler(const std::vector<double>& weights, Backend backend = Backend::ProposalArray) :
+        backend_(make(backend, weights)) {
+        assert(weights.size() > 0);
+        window_ = window();
+    }
+
+    template <typename Generator>
+    size_t sample(Generator&& gen) {
+        samples_++;
+        if (++ops_ >= window_) adapt();
+        return std::visit([&](auto& ds) -> size_t { return ds.sample(gen); }, backend_);
+    }
+
+    void update(size_t i, double w) {
+        assert(i < size());
+        if (!fits(w)) migrate(Backend::ProposalArray);
+        std::visit([&](auto& ds) {
+            changed_ += std::abs(w - ds.weight(i));
+            ds.update(i, w);
+        }, backend_);
+        updates_++;
+        if (++ops_ >= window_) adapt();
+    }
+
+    size_t push(double w) {
+        if (!fits(w)) migrate(Backend::ProposalArray);
+        changed_ += w;
+        size_t i = std::visit([&](auto& ds) -> size_t { return ds.push(w); }, backend_);
+        updates_++;
+        if (++ops_ >= window_) adapt();
+        return i;
+    }
+
+    void pop() {
+        assert(size() > 0);
+        std::visit([&](auto& ds) {
+            changed_ += ds.weight(ds.size() - 1);
+            ds.pop();
+        }, backend_);
+        updates_++;
+        if (++ops_ >= window_) adapt();
+    }
+
+    double weight(size_t i) const {
+        return std::visit([&](const auto& ds) { return ds.weight(i); }, backend_);
+    }
+
+    size_t size() const {
+        return std::visit([](const auto& ds) { return ds.size(); }, backend_);
+    }
+
+    Backend backend() const {
+        return static_cast<Backend>(backend_.index());
+    }
+
+    // number of rebuilds on another backend so far
+    size_t migrations() const {
+        return migrations_;
+    }
+
+    // the statistics of the current window and the decayed earlier ones, takes O(n) time for the spread
+    Stats stats() const {
+        double W = 0;
+        double max = 0;
+        std::visit([&](const auto& ds) {
+            for (size_t i = 0; i < ds.size(); ++i) {
+                W += ds.weight(i);
+                max = std::max(max, ds.weight(i));
+            }
+        }, backend_);
+        Stats s;
+        s.n = size();
+        double avg = W / s.n;
+        double ops = samples_ + updates_;
+        s.update_share = ops > 0 ? updates_ / ops : 0.0;
+        s.update_size = updates_ > 0 && avg > 0 ? changed_ / updates_ / avg : 0.0;
+        s.max = max;
+        s.spread = avg > 0 ? max / avg : 1.0;
+        return s;
+    }
+
+    // estimated nanoseconds per operation on the given backend, interpolated in log n between single-thread
+    // measurements of BenchmarkDriver at n = 10^3 and n = 10^7
+    static double cost(Backend backend, const Stats& s) {
+        const Model& m = models[static_cast<size_t>(backend)];
+        double levels = Model::levels(s.n);
+        double sample = m.sample + m.sample_per_level * levels;
+        double update = m.update + m.update_per_level * levels + m.update_per_avg * s.update_size;
+        return (1 - s.update_share) * sample + s.update_share * update;
+    }
+
+    // estimated nanoseconds to build the given backend
+    static double build_cost(Backend backend, const Stats& s) {
+        const Model& m = models[static_cast<size_t>(backend)];
+        return (m.build + m.build_per_level * Model::levels(s.n)) * s.n;
+    }
+
+private:
+    struct Model {
+        double sample, sample_per_level, update, update_per_level, update_per_avg, build, build_per_level;
+
+        // powers of two beyond the first-level caches
+        static double levels(size_t n) {
+            return std::max(0.0, std::log2(static_cast<double>(n)) - 10);
+        }
+    };
+
+    static constexpr std::array<Model, 3> models = {{
+        {36, 4.3, 31, 26, 10, 14, 3.1}, // the proposals of the updated index change with its weight
+        {48, 11.7, 28, 26, 0, 11, 2.6},
+        {93, 26.5, 21, 9.6, 0, 18, 0},
+    }};
+
+    static Backends make(Backend backend, const std::vector<double>& weights) {
+        switch (backend) {
+            case Backend::LogCascade: return Backends(std::in_place_type<LogCascade<1>>, weights);
+            case Backend::Tree: return Backends(std::in_place_type<BinaryTree<8>>, weights);
+            default: return Backends(std::in_place_type<DynamicProposalArray<>>, weights);
+        }
+    }
+
+    size_t window() const {
+        return std::max<size_t>(2 * size(), size_t(1) << 16);
+    }
+
+    // whether the current backend can hold the weight, only the partitions of the cascade are bounded
+    bool fits(double w) const {
+        auto* cascade = std::get_if<LogCascade<1>>(&backend_);
+        return !cascade || w <= cascade->max_weight();
+    }
+
+    // rebuilds from the weights held by the current backend
+    void migrate(Backend backend) {
+        std::vector<double> weights(size());
+        for (size_t i = 0; i < weights.size(); ++i) weights[i] = weight(i);
+        backend_ = make(backend, weights);
+        migrations_++;
+    }
+
+    void adapt() {
+        Stats s = stats();
+        Backend best = backend();
+        for (Backend b : {Backend::ProposalArray, Backend::LogCascade, Backend::Tree}) {
+            // a fresh cascade holds weights up to at least n^3
+            if (b == Backend::LogCascade && s.max > std::pow(static_cast<double>(s.n), 3)) continue;
+            if (cost(b, s) < cost(best, s)) best = b;
+        }
+        double savings = cost(backend(), s) - cost(best, s);
+        if (savings > 0.25 * cost(backend(), s) && savings * window_ > build_cost(best, s)) migrate(best);
+        samples_ /= 2;
+        updates_ /= 2;
+        changed_ /= 2;
+        ops_ = 0;
+        window_ = window();
+    }
+
+    Backends backend_;
+    double samples_ = 0;
+    double updates_ = 0;
+    double changed_ = 0; // sum of absolute weight changes
+    size_t ops_ = 0;
+    size_t window_;
+    size_t migrations_ = 0;
+};
+
+static_assert(DynamicSampler<DynamicProposalArray<>> && DynamicSampler<LogCascade<1>> && DynamicSampler<BinaryTree<8>>);
+static_assert(DynamicSampler<AdaptiveSampler>);
+
+}
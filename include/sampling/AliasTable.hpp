@@ -1,64 +1,185 @@
 #pragma once
+#include <algorithm>
+#include <array>
 #include <cassert>
+#include <numeric>
 #include <random>
+#include <span>
+#include <string>
 #include <vector>
-#include <tuple>
+#include <sampling/Allocator.hpp>
+#include <sampling/Layout.hpp>
+#include <sampling/MappedFile.hpp>
+#include <sampling/Parallel.hpp>
 
 namespace sampling {
 
+template <typename Layout = WideLayout, typename Weight = double, typename Allocator = std::allocator<std::byte>>
 class AliasTable {
+    using Index = typename Layout::Index;
+    using Threshold = typename Layout::Threshold;
 public:
-    AliasTable(const std::vector<double>& weights) :
-            table_(weights.size()), entry_dist_(0, weights.size() - 1), real_dist_(0, 1) {
+    // entry i yields i if the variate is below threshold and alias otherwise
+    struct Entry {
+        Index alias;
+        Threshold threshold;
+    };
+
+    AliasTable(const std::vector<Weight>& weights) :
+            table_(weights.size()) {
         assert(weights.size() > 0);
+        assert(weights.size() <= std::numeric_limits<Index>::max());
         size_t N = weights.size();
         double W = std::accumulate(weights.begin(), weights.end(), 0.0);
         std::vector<size_t> hi(N); size_t hi_size = 0;
         std::vector<size_t> lo(N); size_t lo_size = 0;
+        std::vector<double> t(N);
         for (size_t i = 0; i < N; ++i) {
-            double t = N * (weights[i] / W);
-            if (t < 1.0) {
+            t[i] = N * (weights[i] / W);
+            if (t[i] < 1.0) {
                 lo[lo_size] = i; lo_size++;
-            } else if (t > 1.0) {
+            } else if (t[i] > 1.0) {
                 hi[hi_size] = i; hi_size++;
             }
-            table_[i] = std::make_tuple(i, i, t);
+            table_[i] = {static_cast<Index>(i), Layout::to_threshold(1.0)};
         }
         while (lo_size > 0 && hi_size > 0) {
             size_t i = lo[lo_size - 1]; lo_size--;
             size_t j = hi[hi_size - 1]; hi_size--;
-            double t_i = std::get<2>(table_[i]);
-            double t_j = std::get<2>(table_[j]);
-            t_j += t_i - 1.0;
-            if (t_j < 1.0) {
+            t[j] += t[i] - 1.0;
+            if (t[j] < 1.0) {
                 lo[lo_size] = j; lo_size++;
-            } else if (t_j > 1.0) {
+            } else if (t[j] > 1.0) {
                 hi[hi_size] = j; hi_size++;
             }
-            table_[i] = std::make_tuple(i, j, t_i);
-            table_[j] = std::make_tuple(j, j, t_j);
-        }
-        while (lo_size > 0) {
-            size_t i = lo[lo_size - 1]; lo_size--;
-            table_[i] = std::make_tuple(i, i, 1.0);
+            table_[i] = {static_cast<Index>(j), Layout::to_threshold(t[i])};
         }
-        while (hi_size > 0) {
-            size_t j = hi[hi_size - 1]; hi_size--;
-            table_[j] = std::make_tuple(j, j, 1.0);
+        // remaining entries keep themselves as alias and accept with probability one
+    }
+
+    // parallel construction by sweeping (PSA): light items are paired with heavy items in the order of the prefix
+    // sums of their deficits 1 - t and excesses t - 1, which splits into independent chunks via merge-path search
+    AliasTable(const std::vector<Weight>& weights, size_t threads) :
+            table_(weights.size()) {
+        assert(weights.size() > 0);
+        assert(weights.size() <= std::numeric_limits<Index>::max());
+        threads = std::max<size_t>(threads, 1);
+        size_t N = weights.size();
+        double W = parallel_sum(threads, weights);
+        auto t = [&](size_t i) { return N * (weights[i] / W); };
+        // stable split into light and heavy items
+        std::vector<size_t> lights(threads + 1, 0);
+        std::vector<size_t> heavies(threads + 1, 0);
+        parallel_for(threads, N, [&](size_t c, size_t begin, size_t end) {
+            for (size_t i = begin; i < end; ++i) {
+                if (t(i) < 1.0) lights[c + 1]++; else heavies[c + 1]++;
+            }
+        });
+        std::partial_sum(lights.begin(), lights.end(), lights.begin());
+        std::partial_sum(heavies.begin(), heavies.end(), heavies.begin());
+        std::vector<size_t> L(lights[threads]);
+        std::vector<size_t> H(heavies[threads]);
+        parallel_for(threads, N, [&](size_t c, size_t begin, size_t end) {
+            size_t l = lights[c];
+            size_t h = heavies[c];
+            for (size_t i = begin; i < end; ++i) {
+                if (t(i) < 1.0) L[l++] = i; else H[h++] = i;
+            }
+        });
+        if (L.empty() || H.empty()) {
+            parallel_for(threads, N, [&](size_t, size_t begin, size_t end) {
+                for (size_t i = begin; i < end; ++i) table_[i] = {static_cast<Index>(i), Layout::to_threshold(1.0)};
+            });
+            return;
         }
+        // D[i] = sum of deficits of the first i lights, E[j] = sum of excesses of the first j heavies
+        auto prefix_sums = [&](const std::vector<size_t>& items, auto&& value) {
+            std::vector<double> sums(items.size() + 1, 0.0);
+            std::vector<double> offsets(threads + 1, 0.0);
+            parallel_for(threads, items.size(), [&](size_t c, size_t begin, size_t end) {
+                for (size_t k = begin; k < end; ++k) offsets[c + 1] += value(items[k]);
+            });
+            std::partial_sum(offsets.begin(), offsets.end(), offsets.begin());
+            parallel_for(threads, items.size(), [&](size_t c, size_t begin, size_t end) {
+                double sum = offsets[c];
+                for (size_t k = begin; k < end; ++k) {
+                    sum += value(items[k]);
+                    sums[k + 1] = sum;
+                }
+            });
+            return sums;
+        };
+        std::vector<double> D = prefix_sums(L, [&](size_t i) { return 1.0 - t(i); });
+        std::vector<double> E = prefix_sums(H, [&](size_t j) { return t(j) - 1.0; });
+        // light i is handled before heavy j iff D[i] < E[j + 1], the last heavy is handled last
+        auto light_first = [&](size_t i, size_t j) {
+            return j + 1 == H.size() || D[i] < E[j + 1];
+        };
+        parallel_for(threads, L.size() + H.size(), [&](size_t, size_t begin, size_t end) {
+            // number of lights among the first begin items of the merged order
+            size_t lo = begin > H.size() ? begin - H.size() : 0;
+            size_t hi = std::min(begin, L.size());
+            while (lo < hi) {
+                size_t mid = (lo + hi) / 2;
+                if (light_first(mid, begin - mid - 1)) lo = mid + 1; else hi = mid;
+            }
+            size_t i = lo;
+            size_t j = begin - lo;
+            for (size_t k = begin; k < end; ++k) {
+                if (i < L.size() && light_first(i, j)) {
+                    table_[L[i]] = {static_cast<Index>(H[j]), Layout::to_threshold(t(L[i]))};
+                    i++;
+                } else if (j + 1 < H.size()) {
+                    table_[H[j]] = {static_cast<Index>(H[j + 1]), Layout::to_threshold(1.0 + E[j + 1] - D[i])};
+                    j++;
+                } else {
+                    table_[H[j]] = {static_cast<Index>(H[j]), Layout::to_threshold(1.0)};
+                    j++;
+                }
+            }
+        });
     }
 
     template <typename Generator>
-    size_t sample(Generator&& gen) {
-        size_t i = entry_dist_(gen);
-        auto [element, alias, threshold] = table_[i];
-        return real_dist_(gen) < threshold ? element : alias;
+    size_t sample(Generator&& gen) const {
+        size_t i = std::uniform_int_distribution<size_t>(0, table_.size() - 1)(gen);
+        auto [alias, threshold] = table_[i];
+        return Layout::variate(gen) < threshold ? i : alias;
+    }
+
+    // draws out.size() samples in blocks: indices and acceptance variates of a block are generated first,
+    // then the table lookups are resolved in a tight loop so that independent memory accesses can overlap
+    template <typename Generator>
+    void sample_n(Generator&& gen, std::span<size_t> out) const {
+        constexpr size_t B = 64;
+        std::uniform_int_distribution<size_t> entry_dist(0, table_.size() - 1);
+        std::array<size_t, B> entries;
+        std::array<typename Layout::Variate, B> variates;
+        for (size_t s = 0; s < out.size(); s += B) {
+            size_t b = std::min(B, out.size() - s);
+            for (size_t k = 0; k < b; ++k) entries[k] = entry_dist(gen);
+            for (size_t k = 0; k < b; ++k) variates[k] = Layout::variate(gen);
+            for (size_t k = 0; k < b; ++k) {
+                auto [alias, threshold] = table_[entries[k]];
+                out[s + k] = variates[k] < threshold ? entries[k] : alias;
+            }
+        }
+    }
+
+    // in bytes, excluding the object itself
+    size_t memory_usage() const {
+        return table_.capacity() * sizeof(Entry);
+    }
+
+    // writes table_ in the format read by MappedAliasTable, throws std::runtime_error on failure
+    void save(const std::string& path) const {
+        OutputFile file(path);
+        auto header = FileHeader::make<Layout>(FileKind::AliasTable, table_.size());
+        file.write_all(header, std::span<const Entry>(table_));
     }
 
 private:
-    std::vector<std::tuple<size_t, size_t, double>> table_;
-    std::uniform_int_distribution<size_t> entry_dist_;
-    std::uniform_real_distribution<double> real_dist_;
+    AllocatedVector<Entry, Allocator> table_;
 };
 
-}
\ No newline at end of file
+}
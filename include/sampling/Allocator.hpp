@@ -0,0 +1,68 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <vector>
+#include <sys/mman.h>
+
+namespace sampling {
+
+// vector of T allocated by Allocator rebound to T; the structures take one allocator type for all of their arrays
+template <typename T, typename Allocator>
+using AllocatedVector = std::vector<T, typename std::allocator_traits<Allocator>::template rebind_alloc<T>>;
+
+// Stateless allocator that backs allocations of at least one huge page by 2 MiB pages, so that random accesses into
+// arrays of gigabytes miss the TLB far less often. It tries explicit huge pages (MAP_HUGETLB) first, which need to be
+// reserved in /proc/sys/vm/nr_hugepages, then maps 2 MiB aligned memory and marks it for transparent huge pages,
+// which the kernel backs lazily if /sys/kernel/mm/transparent_hugepage/enabled is "madvise" or "always". Smaller
+// allocations go to std::allocator. Memory-resource based allocation is available through
+// std::pmr::polymorphic_allocator, which allocates from the default resource.
+template <typename T>
+class HugePageAllocator {
+public:
+    using value_type = T;
+
+    static constexpr size_t huge_page = size_t(1) << 21;
+
+    HugePageAllocator() = default;
+
+    template <typename U>
+    HugePageAllocator(const HugePageAllocator<U>&) {}
+
+    T* allocate(size_t n) {
+        size_t bytes = n * sizeof(T);
+        if (bytes < huge_page) return std::allocator<T>().allocate(n);
+        size_t length = round_up(bytes);
+        void* p = ::mmap(nullptr, length, PROT_READ | PROT_WRITE,
+                         MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB | (21 << MAP_HUGE_SHIFT), -1, 0);
+        if (p != MAP_FAILED) return static_cast<T*>(p);
+        // map one huge page more and trim the mapping to a huge page boundary
+        p = ::mmap(nullptr, length + huge_page, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (p == MAP_FAILED) throw std::bad_alloc();
+        uintptr_t begin = reinterpret_cast<uintptr_t>(p);
+        uintptr_t aligned = (begin + huge_page - 1) & ~(huge_page - 1);
+        if (aligned > begin) ::munmap(p, aligned - begin);
+        ::munmap(reinterpret_cast<void*>(aligned + length), begin + huge_page - aligned);
+        ::madvise(reinterpret_cast<void*>(aligned), length, MADV_HUGEPAGE);
+        return reinterpret_cast<T*>(aligned);
+    }
+
+    void deallocate(T* p, size_t n) {
+        size_t bytes = n * sizeof(T);
+        if (bytes < huge_page) std::allocator<T>().deallocate(p, n);
+        else ::munmap(p, round_up(bytes));
+    }
+
+    template <typename U>
+    bool operator==(const HugePageAllocator<U>&) const {
+        return true;
+    }
+
+private:
+    static size_t round_up(size_t bytes) {
+        return (bytes + huge_page - 1) / huge_page * huge_page;
+    }
+};
+
+}
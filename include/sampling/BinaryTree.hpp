@@ -1,67 +1,231 @@
 #pragma once
+#include <algorithm>
+#include <array>
 #include <cassert>
 #include <random>
+#include <span>
+#include <utility>
 #include <vector>
+#include <sampling/Allocator.hpp>
 
 namespace sampling {
 
+// Implicit K-ary tree over the weights, node j holds the sum of its children K * j, ..., K * j + K - 1. The nodes are
+// stored in groups of K siblings, each aligned to its size, so that the children of a node fill whole cache lines for
+// K = 8 and 16 (half or a quarter of one for K = 4 or 2) and a descent reads one group per level. The leafs S_ + i
+// hold the weights as Weight, the inner nodes 1, ..., S_ - 1 accumulate updates and are kept in double, so that
+// float weights halve the bottom level, which is the largest one and the one that misses the cache on a descent.
+template <size_t K = 2, typename Weight = double, typename Allocator = std::allocator<std::byte>> // number of children per node, e.g. K = 2 corresponds to a binary tree
 class BinaryTree {
-    constexpr static size_t K_ = 2; // number of children per node, e.g. K = 2 corresponds to a binary tree
+    static_assert(K >= 2 && (K & (K - 1)) == 0, "the arity must be a power of two");
+
+    template <typename T>
+    struct alignas(K * sizeof(T) < 64 ? K * sizeof(T) : 64) Group {
+        std::array<T, K> w;
+    };
 public:
-    BinaryTree(const std::vector<double>& weights) : real_dist_(0, 1) {
+    BinaryTree(const std::vector<Weight>& weights) {
         assert(weights.size() > 0);
-        N_ = weights.size();
-        L_ = std::ceil(std::log(weights.size()) / std::log(K_)); // number of layers
-        S_ = std::pow(K_, L_); // offset for leafs
-        T_ = std::vector<double>(S_ * K_, 0.0); // T_[0] is empty so that we don't need to subtract 1 from indices
-        // initialize leafs
-        for (size_t i = 0; i < N_; ++i) {
-            T_[S_ + i] = weights[i];
-        }
-        // initialize inner nodes
-        for (size_t j = S_ - 1; j > 0; --j) {
-            for (size_t k = 0; k < K_; ++k) {
-                T_[j] += T_[K_ * j + k];
+        build(weights, K);
+    }
+
+    template <typename Generator>
+    size_t sample(Generator&& gen) const {
+        const double* T = this->T();
+        // sample x from U(0, C), C = sum_i w_i
+        return descend(1, T[1] * std::uniform_real_distribution<double>(0, 1)(gen));
+    }
+
+    // draws out.size() samples in one descent and writes them in sorted order: the draws reaching a node are split
+    // binomially among its children, so every node is visited at most once per batch
+    template <typename Generator>
+    void sample_n(Generator&& gen, std::span<size_t> out) const {
+        std::uniform_real_distribution<double> real_dist(0, 1);
+        size_t filled = 0;
+        std::vector<std::pair<size_t, size_t>> stack; // nodes and their number of draws, leftmost on top
+        if (out.size() > 0) stack.emplace_back(1, out.size());
+        while (!stack.empty()) {
+            auto [i, count] = stack.back();
+            stack.pop_back();
+            if (count == 1) {
+                out[filled++] = descend(i, node(i) * real_dist(gen));
+                continue;
+            }
+            if (i >= S_) {
+                std::fill_n(out.begin() + filled, count, i - S_);
+                filled += count;
+                continue;
+            }
+            std::array<size_t, K> counts = {};
+            double remaining = 0;
+            for (size_t k = 0; k < K; ++k) remaining += node(K * i + k);
+            size_t last = 0;
+            for (size_t k = 0; k < K && count > 0; ++k) {
+                double wk = node(K * i + k);
+                if (wk <= 0) continue;
+                double p = remaining > wk ? wk / remaining : 1.0;
+                counts[k] = std::binomial_distribution<size_t>(count, p)(gen);
+                count -= counts[k];
+                remaining -= wk;
+                last = k;
+            }
+            counts[last] += count; // rounding leftovers go to the last child with positive weight
+            for (size_t k = K; k-- > 0;) {
+                if (counts[k] > 0) stack.emplace_back(K * i + k, counts[k]);
             }
         }
     }
 
+    // draws k distinct indices into out, each with probability proportional to its weight among the ones not drawn
+    // yet. Drawn leafs are set to zero; afterwards they are restored and the inner nodes above them are recomputed
+    // from their children level by level, touching each of them once. Requires at least k positive weights.
     template <typename Generator>
-    size_t sample(Generator&& gen) {
-        // sample x from U(0, C), C = sum_i w_i
-        auto x = T_[1] * real_dist_(gen);
-        // find corresponding leaf by branching at inner nodes
-        size_t i = 1;
-        while (i < S_) {
-            for (size_t k = 0; k < K_; ++k) {
-                double wk = T_[K_ * i + k];
-                if (x < wk) {
-                    i = K_ * i + k;
-                    break;
-                }
-                x -= wk;
+    void sample_without_replacement(size_t k, Generator&& gen, std::vector<size_t>& out) {
+        assert(k <= N_);
+        out.clear();
+        if (k == 0) return;
+        double* T = this->T();
+        Weight* L = this->L();
+        std::vector<Weight> drawn_weights;
+        drawn_weights.reserve(k);
+        for (size_t s = 0; s < k; ++s) {
+            size_t i = sample(gen);
+            out.push_back(i);
+            drawn_weights.push_back(L[i]);
+            update(i, 0);
+        }
+        std::vector<size_t> nodes;
+        nodes.reserve(k);
+        for (size_t s = 0; s < k; ++s) {
+            L[out[s]] = drawn_weights[s];
+            nodes.push_back((S_ + out[s]) / K);
+        }
+        std::sort(nodes.begin(), nodes.end());
+        nodes.erase(std::unique(nodes.begin(), nodes.end()), nodes.end());
+        while (nodes.front() > 0) {
+            for (size_t j : nodes) {
+                double sum = 0;
+                for (size_t c = 0; c < K; ++c) sum += node(K * j + c);
+                T[j] = sum;
             }
+            for (size_t& j : nodes) j /= K;
+            nodes.erase(std::unique(nodes.begin(), nodes.end()), nodes.end());
         }
-        return i - S_;
     }
 
-    void update(size_t i, double w) {
-        size_t j = S_ + i;
-        assert(j < S_ * K_);
-        double dw = w - T_[j];
+    void update(size_t i, Weight w) {
+        double* T = this->T();
+        Weight* L = this->L();
+        assert(i < N_);
+        double dw = static_cast<double>(w) - L[i];
         // update leaf, then all parents
-        while (j > 0) {
-            T_[j] += dw;
-            j /= K_;
+        L[i] = w;
+        for (size_t j = (S_ + i) / K; j > 0; j /= K) {
+            T[j] += dw;
+        }
+    }
+
+    // appends a leaf, the tree is rebuilt with K times as many leaf slots once all are in use
+    size_t push(Weight w) {
+        if (N_ == S_) {
+            std::vector<Weight> weights(L(), L() + N_);
+            build(weights, K * S_);
         }
+        size_t i = N_++;
+        size_t groups = (N_ + K - 1) / K;
+        if (leafs_.size() < groups) leafs_.resize(groups);
+        update(i, w);
+        return i;
+    }
+
+    // removes the last leaf, the tree keeps its height
+    void pop() {
+        assert(N_ > 0);
+        update(N_ - 1, 0);
+        N_--;
+    }
+
+    Weight weight(size_t i) const {
+        assert(i < N_);
+        return L()[i];
+    }
+
+    size_t size() const {
+        return N_;
     }
 
 private:
-    std::vector<double> T_;
-    std::uniform_real_distribution<double> real_dist_;
+    // lays out the weights below at least min_leafs leaf slots, min_leafs >= K so that the root is an inner node
+    void build(const std::vector<Weight>& weights, size_t min_leafs) {
+        N_ = weights.size();
+        S_ = 1; // offset for leafs
+        while (S_ < N_ || S_ < min_leafs) S_ *= K;
+        // T(0) is empty so that we don't need to subtract 1 from indices, leaf groups past the last leaf are left out
+        G_ = AllocatedVector<Group<double>, Allocator>(S_ / K);
+        leafs_ = AllocatedVector<Group<Weight>, Allocator>((N_ + K - 1) / K);
+        std::copy(weights.begin(), weights.end(), L());
+        // initialize inner nodes, the ones above leaf groups that are left out stay zero
+        double* T = this->T();
+        for (size_t j = std::min(S_ - 1, S_ / K + leafs_.size() - 1); j > 0; --j) {
+            for (size_t k = 0; k < K; ++k) {
+                T[j] += node(K * j + k);
+            }
+        }
+    }
+
+    // leaf of the subtree of node i at prefix sum x, found by branching at inner nodes; a branching scan lets the next
+    // group be loaded speculatively, which outweighs its mispredictions against a branchless prefix comparison
+    size_t descend(size_t i, double x) const {
+        const double* T = this->T();
+        while (K * i < S_) {
+            i = K * i + branch(T + K * i, x);
+        }
+        if (i < S_) {
+            i = K * i + branch(L() + (K * i - S_), x);
+        }
+        return i - S_;
+    }
+
+    // child among K siblings whose range of prefix sums contains x, reduces x to an offset within it; if rounding
+    // leaves x past the sum of the siblings, the last one with positive weight is taken
+    template <typename T>
+    static size_t branch(const T* siblings, double& x) {
+        for (size_t k = 0; k < K; ++k) {
+            double wk = siblings[k];
+            if (x < wk) return k;
+            x -= wk;
+        }
+        size_t k = K - 1;
+        while (k > 0 && !(siblings[k] > 0)) --k;
+        x = siblings[k];
+        return k;
+    }
+
+    // sum of the weights below node j, the weight itself for a leaf
+    double node(size_t j) const {
+        return j < S_ ? T()[j] : L()[j - S_];
+    }
+
+    double* T() {
+        return G_.data()->w.data();
+    }
+
+    const double* T() const {
+        return G_.data()->w.data();
+    }
+
+    Weight* L() {
+        return leafs_.data()->w.data();
+    }
+
+    const Weight* L() const {
+        return leafs_.data()->w.data();
+    }
+
+    AllocatedVector<Group<double>, Allocator> G_;
+    AllocatedVector<Group<Weight>, Allocator> leafs_;
     size_t N_;
-    size_t L_;
     size_t S_;
 };
 
-}
\ No newline at end of file
+}
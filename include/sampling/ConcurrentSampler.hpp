@@ -0,0 +1,87 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <sampling/DynamicProposalArray.hpp>
+
+namespace sampling {
+
+// Concurrent sampling with a single writer via the left-right technique: readers sample from one of two instances
+// while the writer modifies the other one, then the roles are swapped and the modification is repeated on the second
+// instance once the last reader has left it. Readers only announce themselves in a striped read indicator, so sample()
+// is const and wait-free, while the writer applies every modification (including reconstructions) twice and waits
+// for readers to drain. Requires Sampler::sample to be const.
+template <typename Sampler = DynamicProposalArray<>>
+class ConcurrentSampler {
+    constexpr static size_t Stripes = 64;
+
+    struct alignas(64) Counter {
+        std::atomic<int64_t> readers{0};
+    };
+public:
+    template <typename Weight>
+    ConcurrentSampler(const std::vector<Weight>& weights) : instances_{Sampler(weights), Sampler(weights)} {}
+
+    template <typename Generator>
+    size_t sample(Generator&& gen) const {
+        Counter& counter = indicators_[version_.load()][stripe()];
+        counter.readers.fetch_add(1);
+        size_t i = instances_[left_right_.load()].sample(gen);
+        counter.readers.fetch_sub(1, std::memory_order_release);
+        return i;
+    }
+
+    template <typename Weight>
+    void update(size_t i, Weight w) {
+        write([&](Sampler& instance) { instance.update(i, w); });
+    }
+
+    template <typename Weight>
+    size_t push(Weight w) {
+        size_t i = 0;
+        write([&](Sampler& instance) { i = instance.push(w); });
+        return i;
+    }
+
+    void pop() {
+        write([](Sampler& instance) { instance.pop(); });
+    }
+
+private:
+    template <typename F>
+    void write(F&& modify) {
+        std::lock_guard<std::mutex> lock(writer_mutex_);
+        size_t lr = left_right_.load(std::memory_order_relaxed);
+        modify(instances_[1 - lr]);
+        left_right_.store(1 - lr);
+        // readers that might still use instances_[lr] arrived under the previous version
+        size_t prev = version_.load(std::memory_order_relaxed);
+        size_t next = 1 - prev;
+        wait_until_empty(next);
+        version_.store(next);
+        wait_until_empty(prev);
+        modify(instances_[lr]);
+    }
+
+    void wait_until_empty(size_t version) const {
+        for (auto& counter : indicators_[version]) {
+            while (counter.readers.load() != 0) std::this_thread::yield();
+        }
+    }
+
+    static size_t stripe() {
+        static thread_local size_t stripe = std::hash<std::thread::id>()(std::this_thread::get_id()) % Stripes;
+        return stripe;
+    }
+
+    std::array<Sampler, 2> instances_;
+    mutable std::array<std::array<Counter, Stripes>, 2> indicators_;
+    std::atomic<size_t> left_right_{0};
+    std::atomic<size_t> version_{0};
+    std::mutex writer_mutex_;
+};
+
+}
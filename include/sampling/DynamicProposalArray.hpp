@@ -1,73 +1,143 @@
 #pragma once
 #include <cassert>
 #include <functional>
+#include <numeric>
 #include <random>
+#include <span>
+#include <type_traits>
 #include <vector>
+#include <sampling/Allocator.hpp>
+#include <sampling/Layout.hpp>
+#include <sampling/Parallel.hpp>
+#include <sampling/Random.hpp>
+#include <sampling/SlotArena.hpp>
 
 namespace sampling {
 
+// Divides 64-bit numerators by a fixed divisor d through a multiplication with the cached reciprocal
+// M = ceil(2^128 / d), which gives the exact quotient for all numerators below 2^64 (Lemire et al., "Faster
+// Remainder by Direct Computation", 2019).
+class Reciprocal {
+public:
+    Reciprocal(uint64_t d = 1) : d_(d), M_(d > 1 ? ~static_cast<__uint128_t>(0) / d + 1 : 0) {}
+
+    // floor(n / d)
+    uint64_t divide(uint64_t n) const {
+        if (d_ == 1) return n;
+        // the high 64 bits of the 192-bit product M * n
+        __uint128_t low = static_cast<__uint128_t>(static_cast<uint64_t>(M_)) * n;
+        __uint128_t high = static_cast<__uint128_t>(static_cast<uint64_t>(M_ >> 64)) * n;
+        return static_cast<uint64_t>((high + (low >> 64)) >> 64);
+    }
+
+    uint64_t divisor() const {
+        return d_;
+    }
+
+private:
+    uint64_t d_;
+    __uint128_t M_;
+};
+
+// Weight is the type of the stored weights, while the total and the average that every update adds to stay double.
+// Unsigned integer weights, e.g. counts, are handled exactly instead: the total is a 64-bit integer and the average
+// a = max(floor(W / n), 1), an index of weight w has floor(w / a) proposals, computed with a cached reciprocal of a,
+// and keeps its remainder w mod a as residual, which accepts with probability (w mod a) / a by an integer compare.
+template <typename Layout = WideLayout, typename Weight = double, typename Allocator = std::allocator<std::byte>>
 class DynamicProposalArray {
+    using Index = typename Layout::Index;
+    using Threshold = typename Layout::Threshold;
+    static constexpr bool exact = std::is_integral_v<Weight>;
+    static_assert(!exact || std::is_unsigned_v<Weight>, "integer weights must be unsigned");
+    using Total = std::conditional_t<exact, uint64_t, double>;
+    using Residual = std::conditional_t<exact, Weight, Threshold>;
 public:
-    DynamicProposalArray(const std::vector<double>& weights) :
-        weights_(weights), R_(weights.size()), real_dist_(0, 1) {
+    DynamicProposalArray(const std::vector<Weight>& weights) : DynamicProposalArray(weights, 1) {}
+
+    // parallel construction: reduction for W, prefix sum over the proposal counts and placement into P_ and L_
+    DynamicProposalArray(const std::vector<Weight>& weights, size_t threads) :
+        weights_(weights.begin(), weights.end()), R_(weights.size()) {
         assert(weights.size() > 0);
+        assert(2 * weights.size() <= std::numeric_limits<Index>::max());
         N_ = weights.size();
-        W_ = std::accumulate(weights.begin(), weights.end(), 0.0);
-        avg_ = W_ / N_;
+        W_ = parallel_sum<Total>(threads, weights);
+        set_average();
         P_.reserve(2 * N_);
-        construct();
+        construct(threads);
     }
 
     template <typename Generator>
-    size_t sample(Generator&& gen) {
-        std::uniform_int_distribution<size_t> entry_dist(0, R_.size() + P_.size() - 1);
-        do {
-            size_t i = entry_dist(gen);
-            if (i < R_.size()) {
-                double p_acc = R_[i];
-                if (real_dist_(gen) < p_acc) {
-                    return i;
-                }
-            } else {
-                return P_[i - R_.size()].first;
-            }
-        } while (true);
+    size_t sample(Generator&& gen) const {
+        return sample_<false>(gen);
     }
 
-    void update(size_t i, double w) {
+    // takes a single 64-bit word per trial, see multiply_shift
+    template <typename Generator>
+    size_t sample_fast(Generator&& gen) const {
+        return sample_<true>(gen);
+    }
+
+    void update(size_t i, Weight w) {
         assert(i <= N_);
 
-        double w_old = weights_[i];
-        W_ += w - w_old;
+        W_ += static_cast<Total>(w) - weights_[i];
         weights_[i] = w;
 
-        double new_avg = W_ / N_;
-        if (new_avg < avg_ / 2 || new_avg > 2 * avg_) {
-            avg_ = new_avg;
+        if (unbalanced()) {
+            set_average();
             reconstruct();
         } else {
-            if (w > w_old) {
-                size_t count = std::floor(w / avg_);
-                for (size_t c = std::floor(w_old / avg_); c < count; ++c) {
-                    insert(i);
-                }
-                R_[i] = (w / avg_) - count;
-            } else if (w < w_old) {
-                size_t count = std::floor(w / avg_);
-                for (size_t c = std::floor(w_old / avg_); c > count; --c) {
-                    erase(i);
-                }
-                R_[i] = (w / avg_) - count;
+            adjust(i);
+        }
+    }
+
+    // applies a burst of updates with at most one reconstruction, decided on the final total weight;
+    // if an index occurs several times, its last update wins
+    void update_many(std::span<const std::pair<size_t, Weight>> updates) {
+        for (auto [i, w] : updates) {
+            assert(i < N_);
+            W_ += static_cast<Total>(w) - weights_[i];
+            weights_[i] = w;
+        }
+
+        if (unbalanced()) {
+            set_average();
+            reconstruct();
+        } else {
+            for (auto [i, _] : updates) {
+                adjust(i);
             }
         }
     }
 
-    size_t push(double w) {
+    // draws k distinct indices into out, each with probability proportional to its weight among the ones not drawn
+    // yet. Drawn indices lose their proposals while the average stays fixed, so the draw never reconstructs, and are
+    // restored together afterwards. Requires at least k positive weights.
+    template <typename Generator>
+    void sample_without_replacement(size_t k, Generator&& gen, std::vector<size_t>& out) {
+        assert(k <= N_);
+        out.clear();
+        std::vector<Weight> drawn_weights;
+        drawn_weights.reserve(k);
+        for (size_t s = 0; s < k; ++s) {
+            size_t i = sample(gen);
+            out.push_back(i);
+            drawn_weights.push_back(weights_[i]);
+            weights_[i] = 0;
+            adjust(i);
+        }
+        for (size_t s = 0; s < k; ++s) {
+            weights_[out[s]] = drawn_weights[s];
+            adjust(out[s]);
+        }
+    }
+
+    size_t push(Weight w) {
         size_t i = N_;
         N_++;
-        weights_.push_back(0.0);
-        R_.push_back(0.0);
-        L_.push_back(std::vector<size_t>());
+        weights_.push_back(0);
+        R_.push_back(0);
+        L_.push_list();
         update(i, w);
         return i;
     }
@@ -75,64 +145,158 @@ public:
     void pop() {
         assert(N_ > 0);
         size_t i = N_ - 1;
-        update(i, 0.0);
+        update(i, 0);
         weights_.pop_back();
         R_.pop_back();
-        L_.pop_back();
+        L_.pop_list();
         N_--;
     }
 
+    Weight weight(size_t i) const {
+        return weights_[i];
+    }
+
+    Total total_weight() const {
+        return W_;
+    }
+
+    size_t size() const {
+        return N_;
+    }
+
+    // in bytes, excluding the object itself
+    size_t memory_usage() const {
+        return weights_.capacity() * sizeof(Weight) + R_.capacity() * sizeof(Residual)
+                + P_.capacity() * sizeof(std::pair<Index, Index>) + L_.memory_usage();
+    }
+
 private:
-    void construct() {
-        P_.clear();
-        L_ = std::vector<std::vector<size_t>>(N_);
-        for (size_t i = 0; i < N_; ++i) {
-            double weight = weights_[i];
-            size_t count = std::floor(weight / avg_);
-            for (size_t j = 0; j < count; ++j) {
-                insert(i);
+    template <bool Fast, typename Generator>
+    size_t sample_(Generator&& gen) const {
+        std::uniform_int_distribution<size_t> entry_dist(0, R_.size() + P_.size() - 1);
+        do {
+            uint64_t bits;
+            size_t i;
+            if constexpr (Fast) i = multiply_shift(random_word(gen), R_.size() + P_.size(), bits);
+            else i = entry_dist(gen);
+            if (i < R_.size()) {
+                auto p_acc = R_[i];
+                bool accepted;
+                if constexpr (exact && Fast) accepted = multiply_shift(bits, avg_, bits) < p_acc;
+                else if constexpr (exact) accepted = std::uniform_int_distribution<Total>(0, avg_ - 1)(gen) < p_acc;
+                else if constexpr (Fast) accepted = Layout::accept_bits(bits, p_acc);
+                else accepted = Layout::variate(gen) < p_acc;
+                if (accepted) {
+                    return i;
+                }
+            } else {
+                return P_[i - R_.size()].first;
+            }
+        } while (true);
+    }
+
+    void construct(size_t threads) {
+        threads = std::max<size_t>(threads, 1);
+        std::vector<size_t> offsets(threads + 1, 0);
+        parallel_for(threads, N_, [&](size_t t, size_t begin, size_t end) {
+            size_t total = 0;
+            for (size_t i = begin; i < end; ++i) {
+                size_t count = proposals(weights_[i], R_[i]);
+                total += count;
+            }
+            offsets[t + 1] = total;
+        });
+        std::partial_sum(offsets.begin(), offsets.end(), offsets.begin());
+        P_.resize(offsets[threads]);
+        L_.reset(N_, offsets[threads]);
+        parallel_for(threads, N_, [&](size_t t, size_t begin, size_t end) {
+            size_t j = offsets[t];
+            for (size_t i = begin; i < end; ++i) {
+                Residual residual;
+                size_t count = proposals(weights_[i], residual);
+                L_.place(i, j, count);
+                for (size_t c = 0; c < count; ++c, ++j) {
+                    L_(i, c) = j;
+                    P_[j] = {static_cast<Index>(i), static_cast<Index>(c)};
+                }
             }
-            R_[i] = (weight / avg_) - count;
+        });
+    }
+
+    // number of proposals for weight w, writes the acceptance of the residual
+    size_t proposals(Weight w, Residual& residual) const {
+        if constexpr (exact) {
+            uint64_t count = reciprocal_.divide(w);
+            residual = w - count * avg_;
+            return count;
+        } else {
+            double weight = w;
+            size_t count = std::floor(weight / avg_);
+            residual = Layout::to_threshold((weight / avg_) - count);
+            return count;
+        }
+    }
+
+    // whether the average has moved by more than a factor of two since the last reconstruction; the bound from above
+    // keeps the number of proposals below 2n
+    bool unbalanced() const {
+        if constexpr (exact) {
+            // an average of one cannot shrink further
+            __uint128_t total = static_cast<__uint128_t>(avg_) * N_;
+            return (avg_ > 1 && 2 * static_cast<__uint128_t>(W_) < total) || W_ > 2 * total;
+        } else {
+            double new_avg = W_ / N_;
+            return new_avg < avg_ / 2 || new_avg > 2 * avg_;
+        }
+    }
+
+    void set_average() {
+        if constexpr (exact) {
+            avg_ = std::max<uint64_t>(W_ / N_, 1);
+            reciprocal_ = Reciprocal(avg_);
+        } else {
+            avg_ = W_ / N_;
         }
     }
 
     void reconstruct() {
-        std::vector<size_t> counts(N_, 0);
-        for (auto [i, _] : P_) counts[i]++;
         for (size_t i = 0; i < N_; ++i) {
-            double weight = weights_[i];
-            size_t count = std::floor(weight / avg_);
-            for (size_t c = counts[i]; c < count; ++c) {
-                insert(i);
-            }
-            for (size_t c = counts[i]; c > count; --c) {
-                erase(i);
-            }
-            R_[i] = (weight / avg_) - count;
+            adjust(i);
+        }
+    }
+
+    // brings the proposals and residual of i in line with its weight
+    void adjust(size_t i) {
+        size_t count = proposals(weights_[i], R_[i]);
+        for (size_t c = L_.size(i); c < count; ++c) {
+            insert(i);
+        }
+        for (size_t c = L_.size(i); c > count; --c) {
+            erase(i);
         }
     }
 
     void insert(size_t i) {
-        L_[i].push_back(P_.size());
-        P_.emplace_back(i, L_[i].size() - 1);
+        L_.push_back(i, P_.size());
+        P_.emplace_back(i, L_.size(i) - 1);
     }
 
     void erase(size_t i) {
-        assert(L_[i].size() > 0);
-        P_[L_[i].back()] = P_.back();
-        L_[P_.back().first][P_.back().second] = L_[i].back();
+        assert(L_.size(i) > 0);
+        P_[L_.back(i)] = P_.back();
+        L_(P_.back().first, P_.back().second) = L_.back(i);
         P_.pop_back();
-        L_[i].pop_back();
+        L_.pop_back(i);
     }
 
-    std::vector<double> weights_;
-    std::vector<double> R_;
-    std::vector<std::pair<size_t, size_t>> P_;
-    std::vector<std::vector<size_t>> L_;
-    std::uniform_real_distribution<double> real_dist_;
+    AllocatedVector<Weight, Allocator> weights_;
+    AllocatedVector<Residual, Allocator> R_;
+    AllocatedVector<std::pair<Index, Index>, Allocator> P_;
+    SlotArena<Index, Index, Allocator> L_;
     size_t N_;
-    double W_;
-    double avg_;
+    Total W_;
+    Total avg_;
+    Reciprocal reciprocal_; // of avg_ for exact weights
 };
 
 }
\ No newline at end of file
@@ -1,17 +1,26 @@
 #pragma once
+#include <algorithm>
 #include <cassert>
 #include <functional>
 #include <queue>
 #include <random>
 #include <vector>
+#include <sampling/Allocator.hpp>
+#include <sampling/Layout.hpp>
+#include <sampling/Random.hpp>
+#include <sampling/SlotArena.hpp>
 
 namespace sampling {
 
+template <typename Layout = WideLayout, typename Weight = double, typename Allocator = std::allocator<std::byte>> // as in DynamicProposalArray
 class DynamicProposalArrayStar {
+    using Index = typename Layout::Index;
+    using Threshold = typename Layout::Threshold;
 public:
-    DynamicProposalArrayStar(const std::vector<double>& weights) :
-        weights_(weights), R_(weights.size()), real_dist_(0, 1) {
+    DynamicProposalArrayStar(const std::vector<Weight>& weights) :
+        weights_(weights.begin(), weights.end()), R_(weights.size()) {
         assert(weights.size() > 0);
+        assert(2 * weights.size() <= std::numeric_limits<Index>::max());
         N_ = weights.size();
         W_ = std::accumulate(weights.begin(), weights.end(), 0.0);
         avg_ = W_ / N_;
@@ -24,79 +33,114 @@ public:
     }
 
     template <typename Generator>
-    size_t sample(Generator&& gen) {
-        auto& P_cur = cur_ ? P1_ : P2_;
-        auto& P_nxt = cur_ ? P2_ : P1_;
-        size_t buckets;
-        if (s_ >= 0) buckets = R_.size() + P_cur.size() + 2 * P_nxt.size();
-        else buckets = 2 * R_.size() + 2 * P_cur.size() + P_nxt.size();
-        std::uniform_int_distribution<size_t> entry_dist(0, buckets - 1);
-        do {
-            size_t l = entry_dist(gen);
-            size_t i = (s_ >= 0) ? l : l / 2;
-            if (i < R_.size()) {
-                double p_acc = R_[i];
-                if (s_ > 0 && i < s_) {
-                    p_acc *= 2;
-                } else if (s_ < 0 && i < -s_) {
-                    p_acc /= 2;
-                }
-                if (real_dist_(gen) < p_acc) {
-                    return i;
-                }
-            } else {
-                if (s_ >= 0) {
-                    if (i < R_.size() + P_cur.size()) {
-                        return P_cur[i - R_.size()].first;
-                    } else {
-                        return P_nxt[(i - R_.size() - P_cur.size()) / 2].first;
-                    }
-                } else {
-                    if (i < R_.size() + P_cur.size()) {
-                        return P_cur[i - R_.size()].first;
-                    } else {
-                        return P_nxt[2 * (i - R_.size() - P_cur.size())].first;
-                    }
-                }
-            }
-        } while (true);
+    size_t sample(Generator&& gen) const {
+        return sample_<false>(gen);
+    }
+
+    // takes a single 64-bit word per trial, see multiply_shift
+    template <typename Generator>
+    size_t sample_fast(Generator&& gen) const {
+        return sample_<true>(gen);
+    }
+
+    void update(size_t i, Weight w) {
+        set_weight(i, w);
+        rebalance();
+    }
+
+    // draws k distinct indices into out, each with probability proportional to its weight among the ones not drawn
+    // yet. Drawn indices get weight zero without a rebuild step and are restored together afterwards. Requires at
+    // least k positive weights.
+    template <typename Generator>
+    void sample_without_replacement(size_t k, Generator&& gen, std::vector<size_t>& out) {
+        assert(k <= N_);
+        out.clear();
+        std::vector<Weight> drawn_weights;
+        drawn_weights.reserve(k);
+        double W = W_;
+        for (size_t s = 0; s < k; ++s) {
+            size_t i = sample(gen);
+            out.push_back(i);
+            drawn_weights.push_back(weights_[i]);
+            set_weight(i, 0);
+        }
+        for (size_t s = 0; s < k; ++s) {
+            set_weight(out[s], drawn_weights[s]);
+        }
+        W_ = W;
+    }
+
+    size_t push(Weight w) {
+        size_t i = weights_.size();
+        weights_.push_back(0);
+        R_.push_back(0);
+        L_.push_list();
+        N_++;
+        update(i, w);
+        return i;
+    }
+
+    void pop() {
+        assert(weights_.size() > 0);
+        size_t i = weights_.size() - 1;
+        update(i, 0);
+        weights_.pop_back();
+        R_.pop_back();
+        L_.pop_list();
+        N_--;
+        // a front that covered the popped index now lies past the end
+        int64_t N = N_;
+        s_ = std::clamp(s_, -N, N);
+    }
+
+    // in bytes, excluding the object itself
+    size_t memory_usage() const {
+        return weights_.capacity() * sizeof(Weight) + R_.capacity() * sizeof(Threshold)
+                + (P1_.capacity() + P2_.capacity()) * sizeof(std::pair<Index, Index>) + L_.memory_usage();
     }
 
-    void update(size_t i, double w) {
+private:
+    // sets the weight of i and brings its proposals in line with the power of the average it is currently built for
+    void set_weight(size_t i, Weight w) {
         double w_old = weights_[i];
-        W_ += w - w_old;
+        W_ += static_cast<double>(w) - w_old;
         weights_[i] = w;
 
-        double avg_power = (s_ > 0 && i < s_) ? avg_ * 2 : (s_ < 0 && i < -s_) ? avg_ / 2 : avg_;
-        bool d = (s_ > 0 && i < s_) || (s_ < 0 && i < -s_);
+        int64_t j = i;
+        double avg_power = (s_ > 0 && j < s_) ? avg_ * 2 : (s_ < 0 && j < -s_) ? avg_ / 2 : avg_;
+        bool d = (s_ > 0 && j < s_) || (s_ < 0 && j < -s_);
         if (w > w_old) {
             size_t count = std::floor(w / avg_power);
-            size_t old_count = L_[i].size();
+            size_t old_count = L_.size(i);
             for (size_t c = old_count; c < count; ++c) {
                 insert(i, !d);
             }
-            R_[i] = (w / avg_power) - count;
+            R_[i] = Layout::to_threshold((w / avg_power) - count);
         } else if (w < w_old) {
             size_t count = std::floor(w / avg_power);
-            size_t old_count = L_[i].size();
+            size_t old_count = L_.size(i);
             for (size_t c = old_count; c > count; --c) {
                 erase(i, !d);
             }
-            R_[i] = (w / avg_power) - count;
+            R_[i] = Layout::to_threshold((w / avg_power) - count);
         }
+    }
 
-        int64_t steps = 3 * N_ * std::log2((W_ / N_) / prev_avg_);
-        if (W_ / N_ > prev_avg_) steps++;
-        if (W_ / N_ < prev_avg_) steps--;
-        prev_avg_ = W_ / N_;
+    // moves the rebuild front s_ by a number of steps proportional to the change of the average since the last call
+    void rebalance() {
+        int64_t N = N_;
+        int64_t steps = 3 * N * std::log2((W_ / N) / prev_avg_);
+        if (W_ / N > prev_avg_) steps++;
+        if (W_ / N < prev_avg_) steps--;
+        prev_avg_ = W_ / N;
 
-        while (steps > 0 && s_ < N_) {
+        while (steps > 0 && s_ < N) {
             bool d = s_ < 0;
             int64_t j = d ? -s_ - 1 : s_;
             double next_power = d ? avg_ : avg_ * 2;
             double weight = weights_[j];
             size_t count = std::floor(weight / next_power);
-            size_t old_count = L_[j].size();
+            size_t old_count = L_.size(j);
             for (size_t c = 0; c < old_count; ++c) {
                 erase(j, !d);
                 if (steps > 0) steps--;
@@ -105,21 +149,21 @@ public:
                 insert(j, d);
                 if (steps > 0) steps--;
             }
-            R_[j] = (weight / next_power) - count;
+            R_[j] = Layout::to_threshold((weight / next_power) - count);
             s_++;
         }
-        if (s_ >= N_ && W_ / N_ > 2 * avg_) {
+        if (s_ >= N && W_ / N > 2 * avg_) {
             avg_ *= 2;
             s_ = 0;
             cur_ = !cur_;
         }
-        while (steps < 0 && -s_ < N_) {
+        while (steps < 0 && -s_ < N) {
             bool d = s_ > 0;
             int64_t j = d ? s_ - 1 : -s_;
             double next_power = d ? avg_ : avg_ / 2;
             double weight = weights_[j];
             size_t count = std::floor(weight / next_power);
-            size_t old_count = L_[j].size();
+            size_t old_count = L_.size(j);
             for (size_t c = 0; c < old_count; ++c) {
                 erase(j, !d);
                 if (steps < 0) steps++;
@@ -128,73 +172,99 @@ public:
                 insert(j, d);
                 if (steps < 0) steps++;
             }
-            R_[j] = (weight / next_power) - count;
+            R_[j] = Layout::to_threshold((weight / next_power) - count);
             s_--;
         }
-        if (-s_ >= N_ && W_ / N_ < avg_ / 2) {
+        if (-s_ >= N && W_ / N < avg_ / 2) {
             avg_ /= 2;
             s_ = 0;
             cur_ = !cur_;
         }
     }
 
-    size_t push(double w) {
-        size_t i = weights_.size();
-        weights_.push_back(0.0);
-        R_.push_back(0.0);
-        L_.push_back(std::vector<size_t>());
-        N_++;
-        update(i, w);
-        return i;
-    }
-
-    void pop() {
-        assert(weights_.size() > 0);
-        size_t i = weights_.size() - 1;
-        update(i, 0.0);
-        weights_.pop_back();
-        R_.pop_back();
-        L_.pop_back();
-        N_--;
+    // Buckets are in units of the smaller of the two powers of the average in use: of avg_ while growing (s_ >= 0),
+    // where residuals of the s_ rebuilt indices and next proposals take two buckets, and of avg_ / 2 while shrinking,
+    // where all residuals and current proposals take two buckets.
+    template <bool Fast, typename Generator>
+    size_t sample_(Generator&& gen) const {
+        auto& P_cur = cur_ ? P1_ : P2_;
+        auto& P_nxt = cur_ ? P2_ : P1_;
+        bool growing = s_ >= 0;
+        size_t front = growing ? s_ : -s_;
+        size_t residuals = growing ? R_.size() + front : 2 * R_.size();
+        size_t current = growing ? P_cur.size() : 2 * P_cur.size();
+        size_t buckets = residuals + current + (growing ? 2 * P_nxt.size() : P_nxt.size());
+        std::uniform_int_distribution<size_t> entry_dist(0, buckets - 1);
+        do {
+            uint64_t bits;
+            size_t l;
+            if constexpr (Fast) l = multiply_shift(random_word(gen), buckets, bits);
+            else l = entry_dist(gen);
+            if (l < residuals) {
+                size_t i = growing ? (l < 2 * front ? l / 2 : l - front) : l / 2;
+                typename Layout::Acceptance p_acc = R_[i];
+                if (!growing && i < front) {
+                    p_acc /= 2;
+                }
+                bool accepted;
+                if constexpr (Fast) accepted = Layout::accept_bits(bits, p_acc);
+                else accepted = Layout::variate(gen) < p_acc;
+                if (accepted) {
+                    return i;
+                }
+            } else if (l < residuals + current) {
+                l -= residuals;
+                return P_cur[growing ? l : l / 2].first;
+            } else {
+                l -= residuals + current;
+                return P_nxt[growing ? l / 2 : l].first;
+            }
+        } while (true);
     }
 
-private:
     void construct() {
-        L_ = std::vector<std::vector<size_t>>(N_);
+        size_t total = 0;
         for (size_t i = 0; i < N_; ++i) {
             double weight = weights_[i];
             size_t count = std::floor(weight / avg_);
-            for (size_t j = 0; j < count; ++j) {
-                insert(i, true);
+            R_[i] = Layout::to_threshold((weight / avg_) - count);
+            total += count;
+        }
+        L_.reset(N_, total);
+        size_t j = 0;
+        for (size_t i = 0; i < N_; ++i) {
+            size_t count = std::floor(weights_[i] / avg_);
+            L_.place(i, j, count);
+            for (size_t c = 0; c < count; ++c, ++j) {
+                L_(i, c) = P1_.size();
+                P1_.emplace_back(i, c);
             }
-            R_[i] = (weight / avg_) - count;
         }
     }
 
     void insert(size_t i, bool d) {
         if (!cur_) d = !d;
         auto& P_ = d ? P1_ : P2_;
-        L_[i].push_back(P_.size());
-        P_.emplace_back(i, L_[i].size() - 1);
+        L_.push_back(i, P_.size());
+        P_.emplace_back(i, L_.size(i) - 1);
     }
 
     void erase(size_t i, bool d) {
-        assert(L_[i].size() > 0);
+        assert(L_.size(i) > 0);
         if (!cur_) d = !d;
         auto& P_ = d ? P1_ : P2_;
         assert(P_.size() > 0);
-        P_[L_[i].back()] = P_.back();
-        L_[P_.back().first][P_.back().second] = L_[i].back();
+        P_[L_.back(i)] = P_.back();
+        L_(P_.back().first, P_.back().second) = L_.back(i);
         P_.pop_back();
-        L_[i].pop_back();
+        L_.pop_back(i);
     }
 
-    std::vector<double> weights_;
-    std::vector<double> R_;
-    std::vector<std::pair<size_t, size_t>> P1_;
-    std::vector<std::pair<size_t, size_t>> P2_;
-    std::vector<std::vector<size_t>> L_;
-    std::uniform_real_distribution<double> real_dist_;
+    AllocatedVector<Weight, Allocator> weights_;
+    AllocatedVector<Threshold, Allocator> R_;
+    AllocatedVector<std::pair<Index, Index>, Allocator> P1_;
+    AllocatedVector<std::pair<Index, Index>, Allocator> P2_;
+    SlotArena<Index, Index, Allocator> L_;
     size_t N_;
     double W_;
     double avg_;
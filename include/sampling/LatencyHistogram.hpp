@@ -0,0 +1,100 @@
+#pragma once
+#ifndef LATENCY_HISTOGRAM_HPP
+#define LATENCY_HISTOGRAM_HPP
+
+#include <algorithm>
+#include <bit>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace tools {
+
+// Log-linear histogram of latencies in nanoseconds, in the manner of an HDR histogram: values below 2^_bits are
+// counted exactly, larger ones in 2^_bits buckets per power of two, so every recorded value is off by less than
+// 2^-_bits of itself. Recording is a few shifts and one increment, the maximum is kept exactly.
+class LatencyHistogram {
+    using Clock = std::chrono::steady_clock;
+
+    static constexpr uint64_t _bits = 7;
+    static constexpr uint64_t _sub = uint64_t(1) << _bits;
+
+    std::vector<uint64_t> _counts;
+    uint64_t _total;
+    uint64_t _max;
+
+public:
+    LatencyHistogram() : _counts((64 - _bits + 1) * _sub, 0), _total(0), _max(0) {}
+
+    void record(uint64_t ns) {
+        _counts[index(ns)]++;
+        _total++;
+        _max = std::max(_max, ns);
+    }
+
+    // runs f and records its duration, which includes the overhead of reading the clock twice
+    template <typename F>
+    void time(F &&f) {
+        auto begin = Clock::now();
+        f();
+        auto end = Clock::now();
+        record(std::chrono::duration_cast<std::chrono::nanoseconds>(end - begin).count());
+    }
+
+    uint64_t count() const {
+        return _total;
+    }
+
+    uint64_t max() const {
+        return _max;
+    }
+
+    // smallest recorded latency bound such that a fraction q of all records lies at or below it, reported as the
+    // upper end of its bucket
+    uint64_t percentile(double q) const {
+        if (_total == 0)
+            return 0;
+        uint64_t rank = std::max<uint64_t>(1, static_cast<uint64_t>(std::ceil(q * _total)));
+        uint64_t seen = 0;
+        for (size_t k = 0; k < _counts.size(); ++k) {
+            seen += _counts[k];
+            if (seen >= rank)
+                return std::min(highest(k), _max);
+        }
+        return _max;
+    }
+
+    void reset() {
+        std::fill(_counts.begin(), _counts.end(), 0);
+        _total = 0;
+        _max = 0;
+    }
+
+    void report(const std::string &prefix) const {
+        std::cout << prefix << " p50: " << percentile(0.5) << "ns p99: " << percentile(0.99) << "ns p99.9: "
+                  << percentile(0.999) << "ns max: " << _max << "ns" << std::endl;
+    }
+
+private:
+    static size_t index(uint64_t v) {
+        if (v < _sub)
+            return v;
+        uint64_t e = std::bit_width(v) - 1; // e >= _bits
+        return (e - _bits + 1) * _sub + ((v >> (e - _bits)) - _sub);
+    }
+
+    static uint64_t highest(size_t k) {
+        if (k < _sub)
+            return k;
+        uint64_t e = k / _sub + _bits - 1;
+        uint64_t lowest = (_sub + k % _sub) << (e - _bits);
+        return lowest + ((uint64_t(1) << (e - _bits)) - 1);
+    }
+};
+
+}
+
+#endif
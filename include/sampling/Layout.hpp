@@ -0,0 +1,60 @@
+#pragma once
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <random>
+
+namespace sampling {
+
+// Storage layouts for the indices and acceptance thresholds of the proposal array family and the alias table.
+// A threshold t accepts with probability P[variate < t], Acceptance is the type thresholds are compared in.
+// accept_bits performs the same test with the high bits of a uniform 64-bit word instead of a separate variate.
+
+// size_t indices and double thresholds
+struct WideLayout {
+    using Index = size_t;
+    using Threshold = double;
+    using Acceptance = double;
+    using Variate = double;
+
+    static Threshold to_threshold(double p) {
+        return p;
+    }
+
+    template <typename Generator>
+    static Variate variate(Generator&& gen) {
+        std::uniform_real_distribution<double> real_dist(0, 1);
+        return real_dist(gen);
+    }
+
+    static bool accept_bits(uint64_t bits, Acceptance p) {
+        return static_cast<double>(bits) * 0x1p-64 < p;
+    }
+};
+
+// uint32_t indices and fixed-point uint32_t thresholds in units of 2^-32, so that a proposal or alias
+// table entry packs into 8 bytes. Supports fewer than 2^32 elements and proposals.
+struct CompactLayout {
+    using Index = uint32_t;
+    using Threshold = uint32_t;
+    using Acceptance = uint64_t;
+    using Variate = uint32_t;
+
+    static Threshold to_threshold(double p) {
+        double t = std::ldexp(p, 32);
+        if (t >= std::numeric_limits<Threshold>::max()) return std::numeric_limits<Threshold>::max();
+        return t > 0 ? static_cast<Threshold>(t) : 0;
+    }
+
+    template <typename Generator>
+    static Variate variate(Generator&& gen) {
+        std::uniform_int_distribution<Variate> bits_dist;
+        return bits_dist(gen);
+    }
+
+    static bool accept_bits(uint64_t bits, Acceptance t) {
+        return (bits >> 32) < t;
+    }
+};
+
+}
@@ -1,145 +1,237 @@
 #pragma once
 #include <array>
+#include <bit>
 #include <cassert>
+#include <cmath>
+#include <cstdint>
 #include <functional>
+#include <numeric>
 #include <random>
+#include <utility>
 #include <vector>
+#include <sampling/Allocator.hpp>
+#include <sampling/SlotArena.hpp>
 
 namespace sampling {
 
-template <size_t K> // number of layers
+// The bottom layer stores the weights as Weight, the layers above it hold sums of partitions and stay in double.
+template <size_t K, typename Weight = double, typename Allocator = std::allocator<std::byte>> // number of layers and type of the weights
 class LogCascade {
     constexpr static size_t alpha = 3; // weights must lie in [0, n^alpha]
+    constexpr static size_t B = 8; // partitions per block of the top layer
+    using Entry = std::pair<size_t, double>; // index and acceptance probability
+    using Change = std::pair<size_t, double>; // index and weight delta
 public:
-    LogCascade(const std::vector<double>& weights) : real_dist_(0, 1) {
+    LogCascade(const std::vector<Weight>& weights) {
         assert(weights.size() > 0);
         m_ = std::ceil(2 * std::log2(weights.size())) + std::ceil(std::log2(std::pow(weights.size(), alpha))) + 1;
         o_ = std::ceil(2 * std::log2(weights.size()));
         W_ = std::accumulate(weights.begin(), weights.end(), 0.0);
         // initialize weights in bottom layer
-        C_[K].weights = weights;
-        // initialize cascade
-        for (size_t l = K; l > 0; --l) {
-            C_[l].P.resize(m_);
-            C_[l-1].weights = std::vector<double>(m_, 0.0);
-            // distribute indices into partitions by weights
-            for (size_t i = 0; i < C_[l].weights.size(); ++i) {
-                double w = C_[l].weights[i];
-                size_t p = to_partition(w);
-                double w_max = w_max_of(p);
-                C_[l].L.push_back(C_[l].P[p].size());
-                C_[l].P[p].emplace_back(i, w / w_max);
-                C_[l-1].weights[p] += w;
-            }
-        }
+        bottom_.weights.assign(weights.begin(), weights.end());
+        // initialize cascade, the top layer is padded to full blocks
+        build<K>();
+        blocks_.assign(C_[0].weights.size() / B, 0.0);
+        for (size_t p = 0; p < m_; ++p) blocks_[p / B] += C_[0].weights[p];
     }
 
     template <typename Generator>
-    size_t sample(Generator&& gen) {
-        // sample partition in top layer via linear search
-        double x = W_ * real_dist_(gen);
-        size_t p = o_;
-        size_t p_max = m_ - 1;
-        while (x > 0) {
-            if (p < p_max) p++; else p = 0;
-            x -= C_[0].weights[p];
-        }
+    size_t sample(Generator&& gen) const {
         // sample index from cascade via rejection sampling
-        size_t l = 1;
-        while (l <= K) {
-            std::uniform_int_distribution<size_t> index_dist(0, C_[l].P[p].size() - 1);
-            while (true) {
-                auto [i, p_acc] = C_[l].P[p][index_dist(gen)];
-                if (real_dist_(gen) < p_acc) {
-                    p = i;
-                    l++;
-                    break;
-                }
-            }
-        }
-        return p;
+        return sample_<1>(gen, sample_partition(gen));
     }
 
-    void update(size_t i, double w_new) {
-        double w = C_[K].weights[i];
-        double delta = w_new - w;
+    void update(size_t i, Weight w_new) {
+        double w = bottom_.weights[i];
+        double delta = static_cast<double>(w_new) - w;
         W_ += delta;
-        update_(K, i, delta);
+        update_<K>({Change(i, delta)}, 1);
     }
 
-    size_t push(double w, size_t l = K) {
-        size_t i = C_[l].weights.size();
+    size_t push(Weight w) {
+        size_t i = bottom_.weights.size();
         size_t p = to_partition(0);
         double w_max = w_max_of(p);
-        C_[l].weights.push_back(0);
-        C_[l].L.push_back(C_[l].P[p].size());
-        C_[l].P[p].emplace_back(i, w / w_max);
+        bottom_.weights.push_back(0);
+        bottom_.L.push_back(bottom_.P.size(p));
+        bottom_.P.push_back(p, Entry(i, w / w_max));
         update(i, w);
         return i;
     }
 
     void pop() {
-        assert(C_[K].weights.size() > 0);
-        size_t i = C_[K].weights.size() - 1;
+        assert(bottom_.weights.size() > 0);
+        size_t i = bottom_.weights.size() - 1;
         update(i, 0);
-        size_t p = to_partition(0);
-        C_[K].P[p][C_[K].L[i]] = C_[K].P[p].back();
-        C_[K].L[C_[K].P[p].back().first] = C_[K].L[i];
-        C_[K].P[p].pop_back();
-        C_[K].L.pop_back();
-        C_[K].weights.pop_back();
+        erase(bottom_, to_partition(0), i);
+        bottom_.L.pop_back();
+        bottom_.weights.pop_back();
+    }
+
+    Weight weight(size_t i) const {
+        return bottom_.weights[i];
+    }
+
+    size_t size() const {
+        return bottom_.weights.size();
+    }
+
+    // largest weight the partitions can hold, they are laid out for weights up to n^alpha at construction
+    double max_weight() const {
+        return w_max_of(m_ - 1);
     }
 
 private:
-    size_t to_partition(double w) {
-        if (w > 1) {
-            size_t p = std::ceil(std::log2(w));
-            return o_ + p;
-        } else if (w > 0) {
-            size_t p = std::floor(-std::log2(w));
-            return o_ <= p ? 0 : o_ - p;
-        } else {
-            return 0;
+    template <typename W>
+    struct Layer {
+        SlotArena<Entry, size_t, Allocator> P; // one list per partition
+        AllocatedVector<size_t, Allocator> L; // position of each index in its partition
+        AllocatedVector<W, Allocator> weights;
+    };
+
+    template <size_t l>
+    auto& layer() {
+        if constexpr (l == K) return bottom_;
+        else return C_[l];
+    }
+
+    template <size_t l>
+    const auto& layer() const {
+        if constexpr (l == K) return bottom_;
+        else return C_[l];
+    }
+
+    // partitions the indices of layer l by their weights and sums up the partitions into layer l - 1
+    template <size_t l>
+    void build() {
+        auto& layer = this->layer<l>();
+        size_t n = layer.weights.size();
+        C_[l-1].weights.assign(l > 1 ? m_ : (m_ + B - 1) / B * B, 0.0);
+        // distribute indices into partitions by weights, laid out back to back with slack for a quarter more
+        std::vector<size_t> sizes(m_, 0);
+        for (size_t i = 0; i < n; ++i) sizes[to_partition(layer.weights[i])]++;
+        std::vector<size_t> offsets(m_ + 1, 0);
+        for (size_t p = 0; p < m_; ++p) offsets[p + 1] = offsets[p] + sizes[p] + sizes[p] / 4 + 1;
+        layer.P.reset(m_, offsets[m_]);
+        for (size_t p = 0; p < m_; ++p) layer.P.place(p, offsets[p], sizes[p], offsets[p + 1] - offsets[p]);
+        layer.L.resize(n);
+        std::vector<size_t> filled(m_, 0);
+        for (size_t i = 0; i < n; ++i) {
+            double w = layer.weights[i];
+            size_t p = to_partition(w);
+            double w_max = w_max_of(p);
+            layer.L[i] = filled[p]++;
+            layer.P(p, layer.L[i]) = Entry(i, w / w_max);
+            C_[l-1].weights[p] += w;
         }
+        if constexpr (l > 1) build<l - 1>();
     }
 
-    double w_max_of(size_t p) {
-        return std::pow(2, p) / std::pow(2, o_);
+    // o_ + ceil(log2(w)) clamped at zero, read off the exponent and mantissa bits of w
+    size_t to_partition(double w) const {
+        if (!(w > 0)) return 0;
+        uint64_t bits = std::bit_cast<uint64_t>(w);
+        int64_t exponent = static_cast<int64_t>(bits >> 52) - 1023;
+        int64_t p = static_cast<int64_t>(o_) + exponent + ((bits & ((uint64_t(1) << 52) - 1)) != 0);
+        return p > 0 ? p : 0;
     }
 
-    void update_(size_t l, size_t i, double delta) {
-        double w = C_[l].weights[i];
-        double w_new = w + delta;
-        C_[l].weights[i] = w_new;
-        if (l == 0) return;
-        size_t p = to_partition(w);
-        size_t p_new = to_partition(w_new);
-        assert(p_new < m_);
-        double w_max = w_max_of(p_new);
-        if (p == p_new) {
-            C_[l].P[p][C_[l].L[i]].second = w_new / w_max;
-            update_(l - 1, p, delta);
+    double w_max_of(size_t p) const {
+        return std::ldexp(1.0, static_cast<int>(p) - static_cast<int>(o_));
+    }
+
+    // scans the block sums of the top layer from the heaviest partitions downwards, then resolves the block by a
+    // branchless prefix comparison; retries if rounding drift between the sums leaves no partition to pick
+    template <typename Generator>
+    size_t sample_partition(Generator&& gen) const {
+        std::uniform_real_distribution<double> real_dist(0, 1);
+        const double* weights = C_[0].weights.data();
+        while (true) {
+            double x = W_ * real_dist(gen);
+            for (size_t b = blocks_.size(); b-- > 0;) {
+                if (x >= blocks_[b]) {
+                    x -= blocks_[b];
+                    continue;
+                }
+                double prefix = 0;
+                size_t k = 0;
+                for (size_t j = 0; j < B; ++j) {
+                    prefix += weights[b * B + j];
+                    k += prefix <= x;
+                }
+                size_t p = b * B + k;
+                if (k < B && p < m_ && layer<1>().P.size(p) > 0) return p;
+                break;
+            }
+        }
+    }
+
+    template <size_t l, typename Generator>
+    size_t sample_(Generator&& gen, size_t p) const {
+        const auto& P = layer<l>().P;
+        std::uniform_int_distribution<size_t> index_dist(0, P.size(p) - 1);
+        std::uniform_real_distribution<double> real_dist(0, 1);
+        while (true) {
+            auto [i, p_acc] = P(p, index_dist(gen));
+            if (real_dist(gen) < p_acc) {
+                if constexpr (l == K) return i;
+                else return sample_<l + 1>(gen, i);
+            }
+        }
+    }
+
+    template <typename W>
+    static void erase(Layer<W>& layer, size_t p, size_t i) {
+        Entry last = layer.P.back(p);
+        layer.P(p, layer.L[i]) = last;
+        layer.L[last.first] = layer.L[i];
+        layer.P.pop_back(p);
+    }
+
+    // applies the weight changes of layer l, of which there are at most 2^(K - l), and passes the resulting
+    // changes of partition weights on to layer l - 1
+    template <size_t l>
+    void update_(const std::array<Change, (size_t(1) << (K - l))>& changes, size_t count) {
+        auto& layer = this->layer<l>();
+        if constexpr (l == 0) {
+            for (size_t k = 0; k < count; ++k) {
+                auto [p, delta] = changes[k];
+                layer.weights[p] += delta;
+                blocks_[p / B] += delta;
+            }
         } else {
-            C_[l].P[p][C_[l].L[i]] = C_[l].P[p].back();
-            C_[l].L[C_[l].P[p].back().first] = C_[l].L[i];
-            C_[l].P[p].pop_back();
-            C_[l].L[i] = C_[l].P[p_new].size();
-            C_[l].P[p_new].emplace_back(i, w_new / w_max);
-            update_(l - 1, p, -w);
-            update_(l - 1, p_new, w_new);
+            std::array<Change, (size_t(1) << (K - l + 1))> next;
+            size_t next_count = 0;
+            for (size_t k = 0; k < count; ++k) {
+                auto [i, delta] = changes[k];
+                double w = layer.weights[i];
+                double w_new = w + delta;
+                layer.weights[i] = w_new;
+                size_t p = to_partition(w);
+                size_t p_new = to_partition(w_new);
+                assert(p_new < m_);
+                double w_max = w_max_of(p_new);
+                if (p == p_new) {
+                    layer.P(p, layer.L[i]).second = w_new / w_max;
+                    next[next_count++] = Change(p, delta);
+                } else {
+                    erase(layer, p, i);
+                    layer.L[i] = layer.P.size(p_new);
+                    layer.P.push_back(p_new, Entry(i, w_new / w_max));
+                    next[next_count++] = Change(p, -w);
+                    next[next_count++] = Change(p_new, w_new);
+                }
+            }
+            update_<l - 1>(next, next_count);
         }
     }
 
-    struct Layer {
-        std::vector<std::vector<std::pair<size_t, double>>> P;
-        std::vector<size_t> L;
-        std::vector<double> weights;
-    };
-    std::array<Layer, K + 1> C_;
-    std::uniform_real_distribution<double> real_dist_;
+    std::array<Layer<double>, K> C_;
+    Layer<Weight> bottom_;
+    std::vector<double> blocks_; // sums of B consecutive partition weights of the top layer
     size_t m_;
     size_t o_;
     double W_;
 };
 
-}
\ No newline at end of file
+}
@@ -0,0 +1,40 @@
+#pragma once
+#include <random>
+#include <span>
+#include <string>
+#include <sampling/AliasTable.hpp>
+#include <sampling/Layout.hpp>
+#include <sampling/MappedFile.hpp>
+
+namespace sampling {
+
+// read-only AliasTable sampling directly from a file written by AliasTable::save
+template <typename Layout = WideLayout>
+class MappedAliasTable {
+    using Entry = typename AliasTable<Layout>::Entry;
+public:
+    explicit MappedAliasTable(const std::string& path) : file_(path) {
+        auto& header = file_.header<Layout>(FileKind::AliasTable);
+        table_ = file_.array<Entry>(header, 0);
+        if (table_.size() != header.size || table_.empty())
+            throw std::runtime_error("corrupt sampler file '" + path + "'");
+    }
+
+    template <typename Generator>
+    size_t sample(Generator&& gen) const {
+        std::uniform_int_distribution<size_t> entry_dist(0, table_.size() - 1);
+        size_t i = entry_dist(gen);
+        auto [alias, threshold] = table_[i];
+        return Layout::variate(gen) < threshold ? i : alias;
+    }
+
+    size_t size() const {
+        return table_.size();
+    }
+
+private:
+    MappedFile file_;
+    std::span<const Entry> table_;
+};
+
+}
@@ -0,0 +1,207 @@
+#pragma once
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace sampling {
+
+// On-disk format of a built ProposalArray or AliasTable: a header followed by up to two arrays, each starting at a
+// 64-byte aligned offset, in the native byte order. A mapped file is sampled in place without deserialization.
+enum class FileKind : uint32_t {
+    ProposalArray = 1,
+    AliasTable = 2
+};
+
+struct FileHeader {
+    static constexpr char expected_magic[8] = {'S', 'M', 'P', 'L', 'A', 'R', 'R', 'Y'};
+    static constexpr uint32_t current_version = 1;
+
+    struct Array {
+        uint64_t offset;
+        uint64_t count;
+    };
+
+    char magic[8];
+    uint32_t version;
+    FileKind kind;
+    uint32_t index_bytes;
+    uint32_t threshold_bytes;
+    uint64_t size; // number of elements of the distribution
+    Array arrays[2];
+
+    template <typename Layout>
+    static FileHeader make(FileKind kind, uint64_t size) {
+        FileHeader header = {};
+        std::memcpy(header.magic, expected_magic, sizeof(magic));
+        header.version = current_version;
+        header.kind = kind;
+        header.index_bytes = sizeof(typename Layout::Index);
+        header.threshold_bytes = sizeof(typename Layout::Threshold);
+        header.size = size;
+        return header;
+    }
+
+    static uint64_t align(uint64_t offset) {
+        return (offset + 63) / 64 * 64;
+    }
+};
+
+inline std::runtime_error file_error(const std::string& what, const std::string& path) {
+    return std::runtime_error(what + " '" + path + "': " + std::strerror(errno));
+}
+
+// write-only file with positioned writes
+class OutputFile {
+public:
+    explicit OutputFile(const std::string& path) : path_(path) {
+        fd_ = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if (fd_ < 0) throw file_error("cannot create", path);
+    }
+
+    OutputFile(const OutputFile&) = delete;
+    OutputFile& operator=(const OutputFile&) = delete;
+
+    ~OutputFile() {
+        ::close(fd_);
+    }
+
+    void write(uint64_t offset, const void* data, size_t bytes) {
+        auto bytes_ptr = static_cast<const char*>(data);
+        while (bytes > 0) {
+            ssize_t written = ::pwrite(fd_, bytes_ptr, bytes, offset);
+            if (written < 0 && errno == EINTR) continue;
+            if (written <= 0) throw file_error("cannot write", path_);
+            bytes_ptr += written;
+            bytes -= written;
+            offset += written;
+        }
+    }
+
+    template <typename T>
+    void write(uint64_t offset, std::span<const T> values) {
+        write(offset, values.data(), values.size_bytes());
+    }
+
+    // writes the header and the arrays at consecutive aligned offsets, filling in the array table of the header; an
+    // empty second array gets offset 0, as its aligned offset may lie past the end of the file
+    template <typename T0, typename T1 = char>
+    void write_all(FileHeader header, std::span<const T0> first, std::span<const T1> second = {}) {
+        header.arrays[0] = {FileHeader::align(sizeof(FileHeader)), first.size()};
+        header.arrays[1] = {second.empty() ? 0 : FileHeader::align(header.arrays[0].offset + first.size_bytes()),
+                            second.size()};
+        write(header.arrays[0].offset, first);
+        write(header.arrays[1].offset, second);
+        write(0, &header, sizeof(header));
+    }
+
+private:
+    std::string path_;
+    int fd_;
+};
+
+// appends values to an array of an OutputFile starting at the given offset, buffering up to chunk values
+template <typename T>
+class ArrayWriter {
+public:
+    ArrayWriter(OutputFile& file, uint64_t offset, size_t chunk) : file_(file), offset_(offset), chunk_(chunk) {
+        buffer_.reserve(chunk);
+    }
+
+    void push_back(T value) {
+        buffer_.push_back(value);
+        if (buffer_.size() == chunk_) flush();
+    }
+
+    void flush() {
+        file_.write(offset_ + count_ * sizeof(T), std::span<const T>(buffer_));
+        count_ += buffer_.size();
+        buffer_.clear();
+    }
+
+    // values written so far, including buffered ones
+    size_t size() const {
+        return count_ + buffer_.size();
+    }
+
+private:
+    OutputFile& file_;
+    uint64_t offset_;
+    size_t chunk_;
+    size_t count_ = 0;
+    std::vector<T> buffer_;
+};
+
+// read-only memory mapping of a whole file, shared with every other process mapping it through the page cache
+class MappedFile {
+public:
+    explicit MappedFile(const std::string& path) : path_(path) {
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) throw file_error("cannot open", path);
+        struct stat st;
+        if (::fstat(fd, &st) < 0) {
+            ::close(fd);
+            throw file_error("cannot stat", path);
+        }
+        bytes_ = st.st_size;
+        if (bytes_ < sizeof(FileHeader)) {
+            ::close(fd);
+            throw std::runtime_error("truncated sampler file '" + path + "'");
+        }
+        data_ = ::mmap(nullptr, bytes_, PROT_READ, MAP_SHARED, fd, 0);
+        ::close(fd);
+        if (data_ == MAP_FAILED) throw file_error("cannot map", path);
+    }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    ~MappedFile() {
+        ::munmap(data_, bytes_);
+    }
+
+    // the header after checking that it describes a file of the given kind and layout that fits into the mapping
+    template <typename Layout>
+    const FileHeader& header(FileKind kind) const {
+        auto& header = *static_cast<const FileHeader*>(data_);
+        if (std::memcmp(header.magic, FileHeader::expected_magic, sizeof(header.magic)) != 0)
+            throw std::runtime_error("not a sampler file '" + path_ + "'");
+        if (header.version != FileHeader::current_version)
+            throw std::runtime_error("unsupported version " + std::to_string(header.version) + " of '" + path_ + "'");
+        if (header.kind != kind || header.index_bytes != sizeof(typename Layout::Index)
+            || header.threshold_bytes != sizeof(typename Layout::Threshold))
+            throw std::runtime_error("sampler file '" + path_ + "' holds a different structure or layout");
+        for (auto [offset, count] : header.arrays) {
+            if (count == 0) continue; // empty arrays hold no data, files of earlier writers may place them past the end
+            if (offset % 64 != 0 || offset > bytes_ || count > (bytes_ - offset))
+                throw std::runtime_error("truncated sampler file '" + path_ + "'");
+        }
+        return header;
+    }
+
+    template <typename T>
+    std::span<const T> array(const FileHeader& header, size_t k) const {
+        auto [offset, count] = header.arrays[k];
+        if (count == 0) return {};
+        if (count * sizeof(T) > bytes_ - offset) throw std::runtime_error("truncated sampler file '" + path_ + "'");
+        return {reinterpret_cast<const T*>(static_cast<const char*>(data_) + offset), count};
+    }
+
+    size_t bytes() const {
+        return bytes_;
+    }
+
+private:
+    std::string path_;
+    void* data_;
+    size_t bytes_;
+};
+
+}
@@ -0,0 +1,55 @@
+#pragma once
+#include <random>
+#include <span>
+#include <string>
+#include <sampling/Layout.hpp>
+#include <sampling/MappedFile.hpp>
+#include <sampling/Random.hpp>
+
+namespace sampling {
+
+// read-only ProposalArray sampling directly from a file written by ProposalArray::save
+template <typename Layout = WideLayout>
+class MappedProposalArray {
+    using Index = typename Layout::Index;
+    using Threshold = typename Layout::Threshold;
+public:
+    explicit MappedProposalArray(const std::string& path) : file_(path) {
+        auto& header = file_.header<Layout>(FileKind::ProposalArray);
+        R_ = file_.array<Threshold>(header, 0);
+        P_ = file_.array<Index>(header, 1);
+        if (R_.size() != header.size || R_.empty())
+            throw std::runtime_error("corrupt sampler file '" + path + "'");
+    }
+
+    template <typename Generator>
+    size_t sample(Generator&& gen) const {
+        std::uniform_int_distribution<size_t> entry_dist(0, R_.size() + P_.size() - 1);
+        do {
+            size_t i = entry_dist(gen);
+            if (i >= R_.size()) return P_[i - R_.size()];
+            if (Layout::variate(gen) < R_[i]) return i;
+        } while (true);
+    }
+
+    template <typename Generator>
+    size_t sample_fast(Generator&& gen) const {
+        do {
+            uint64_t bits;
+            size_t i = multiply_shift(random_word(gen), R_.size() + P_.size(), bits);
+            if (i >= R_.size()) return P_[i - R_.size()];
+            if (Layout::accept_bits(bits, R_[i])) return i;
+        } while (true);
+    }
+
+    size_t size() const {
+        return R_.size();
+    }
+
+private:
+    MappedFile file_;
+    std::span<const Threshold> R_;
+    std::span<const Index> P_;
+};
+
+}
@@ -0,0 +1,106 @@
+#pragma once
+#include <algorithm>
+#include <cassert>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include <pthread.h>
+#include <sched.h>
+
+namespace sampling {
+
+// NUMA nodes with CPUs and the CPUs of each, read from /sys/devices/system/node without an external library. Without
+// that directory, e.g. on a kernel built without NUMA support, the machine counts as a single node.
+class NumaTopology {
+public:
+    static const NumaTopology& instance() {
+        static NumaTopology topology;
+        return topology;
+    }
+
+    size_t nodes() const {
+        return cpus_.size();
+    }
+
+    const std::vector<int>& cpus(size_t node) const {
+        return cpus_[node];
+    }
+
+    size_t node_of_cpu(int cpu) const {
+        return cpu >= 0 && static_cast<size_t>(cpu) < node_of_cpu_.size() ? node_of_cpu_[cpu] : 0;
+    }
+
+    // node of the CPU the calling thread runs on
+    size_t current_node() const {
+        return node_of_cpu(sched_getcpu());
+    }
+
+    // node the calling thread was pinned to, or the one it ran on when first asked if it was not pinned; unlike
+    // current_node it is a thread-local read, which keeps hot loops free of calls
+    size_t thread_node() const {
+        size_t& node = thread_node_();
+        if (node == unknown) node = current_node();
+        return node;
+    }
+
+    // restricts the calling thread to the CPUs of the node, returns false if the kernel refuses
+    bool pin_to_node(size_t node) const {
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        for (int cpu : cpus_[node]) CPU_SET(cpu, &set);
+        if (pthread_setaffinity_np(pthread_self(), sizeof(set), &set) != 0) return false;
+        thread_node_() = node;
+        return true;
+    }
+
+private:
+    NumaTopology() {
+        const std::string path = "/sys/devices/system/node/";
+        for (int node : read_list(path + "online")) {
+            std::vector<int> cpus = read_list(path + "node" + std::to_string(node) + "/cpulist");
+            if (!cpus.empty()) cpus_.push_back(cpus); // nodes with memory only hold no replicas
+        }
+        if (cpus_.empty()) {
+            cpus_.emplace_back();
+            for (unsigned cpu = 0; cpu < std::max(std::thread::hardware_concurrency(), 1u); ++cpu) {
+                cpus_[0].push_back(cpu);
+            }
+        }
+        for (size_t node = 0; node < cpus_.size(); ++node) {
+            for (int cpu : cpus_[node]) {
+                if (static_cast<size_t>(cpu) >= node_of_cpu_.size()) node_of_cpu_.resize(cpu + 1, 0);
+                node_of_cpu_[cpu] = node;
+            }
+        }
+    }
+
+    // parses a list such as "0-3,8,10-11" as used by sysfs, an empty list if the file cannot be read
+    static std::vector<int> read_list(const std::string& path) {
+        std::vector<int> values;
+        std::ifstream in(path);
+        std::string range;
+        while (std::getline(in, range, ',')) {
+            int first, last;
+            char dash;
+            std::istringstream parse(range);
+            if (!(parse >> first)) break;
+            if (!(parse >> dash >> last)) last = first;
+            for (int value = first; value <= last; ++value) values.push_back(value);
+        }
+        return values;
+    }
+
+    static constexpr size_t unknown = -1;
+
+    static size_t& thread_node_() {
+        thread_local size_t node = unknown;
+        return node;
+    }
+
+    std::vector<std::vector<int>> cpus_;
+    std::vector<size_t> node_of_cpu_;
+};
+
+}
@@ -0,0 +1,36 @@
+#pragma once
+#include <algorithm>
+#include <thread>
+#include <vector>
+
+namespace sampling {
+
+// runs f(t, begin, end) for t = 0, ..., threads - 1 on its own thread, where [begin, end) is the t-th of
+// threads balanced chunks of [0, n); the chunks are the same for equal threads and n
+template <typename F>
+void parallel_for(size_t threads, size_t n, F&& f) {
+    threads = std::max<size_t>(threads, 1);
+    std::vector<std::thread> workers;
+    workers.reserve(threads - 1);
+    for (size_t t = 1; t < threads; ++t) {
+        workers.emplace_back([&f, t, threads, n] { f(t, n * t / threads, n * (t + 1) / threads); });
+    }
+    f(0, 0, n / threads);
+    for (auto& worker : workers) worker.join();
+}
+
+// sums up in Sum, e.g. uint64_t to add up integer weights exactly
+template <typename Sum = double, typename T>
+Sum parallel_sum(size_t threads, const std::vector<T>& values) {
+    std::vector<Sum> sums(std::max<size_t>(threads, 1), 0);
+    parallel_for(threads, values.size(), [&](size_t t, size_t begin, size_t end) {
+        Sum sum = 0;
+        for (size_t i = begin; i < end; ++i) sum += values[i];
+        sums[t] = sum;
+    });
+    Sum sum = 0;
+    for (auto s : sums) sum += s;
+    return sum;
+}
+
+}
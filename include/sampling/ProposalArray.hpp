@@ -1,38 +1,124 @@
 #pragma once
+#include <algorithm>
+#include <array>
 #include <cassert>
+#include <numeric>
 #include <random>
+#include <span>
+#include <string>
 #include <vector>
+#include <sampling/Allocator.hpp>
+#include <sampling/Layout.hpp>
+#include <sampling/MappedFile.hpp>
+#include <sampling/Parallel.hpp>
+#include <sampling/Random.hpp>
 
 namespace sampling {
 
+template <typename Layout = WideLayout, typename Weight = double, typename Allocator = std::allocator<std::byte>>
 class ProposalArray {
+    using Index = typename Layout::Index;
+    using Threshold = typename Layout::Threshold;
 public:
-    ProposalArray(const std::vector<double>& weights) : real_dist_(0, 1) {
+    ProposalArray(const std::vector<Weight>& weights) : ProposalArray(weights, 1) {}
+
+    // parallel construction: reduction for W, prefix sum over the proposal counts and placement into P_
+    ProposalArray(const std::vector<Weight>& weights, size_t threads) {
         assert(weights.size() > 0);
-        double W = 0;
-        for (auto w : weights) W += w;
+        assert(weights.size() <= std::numeric_limits<Index>::max());
+        threads = std::max<size_t>(threads, 1);
+        double W = parallel_sum(threads, weights);
         size_t N = weights.size();
         double avg = W / N;
-        P_.reserve(N);
         R_.resize(N);
-        for (size_t i = 0; i < N; ++i) {
-            double weight = weights[i];
-            size_t count = std::floor(weight / avg);
-            for (size_t j = 0; j < count; ++j) {
-                P_.push_back(i);
+        std::vector<size_t> offsets(threads + 1, 0);
+        parallel_for(threads, N, [&](size_t t, size_t begin, size_t end) {
+            size_t total = 0;
+            for (size_t i = begin; i < end; ++i) {
+                double weight = weights[i];
+                size_t count = std::floor(weight / avg);
+                R_[i] = Layout::to_threshold((weight / avg) - count);
+                total += count;
             }
-            R_[i] = (weight / avg) - count;
-        }
-        entry_dist_ = std::uniform_int_distribution<size_t>(0, R_.size() + P_.size() - 1);
+            offsets[t + 1] = total;
+        });
+        std::partial_sum(offsets.begin(), offsets.end(), offsets.begin());
+        P_.resize(offsets[threads]);
+        parallel_for(threads, N, [&](size_t t, size_t begin, size_t end) {
+            size_t j = offsets[t];
+            for (size_t i = begin; i < end; ++i) {
+                size_t count = std::floor(weights[i] / avg);
+                for (size_t c = 0; c < count; ++c) {
+                    P_[j++] = i;
+                }
+            }
+        });
     }
 
     template <typename Generator>
-    size_t sample(Generator&& gen) {
+    size_t sample(Generator&& gen) const {
+        return sample_<false>(gen);
+    }
+
+    // takes a single 64-bit word per trial, see multiply_shift
+    template <typename Generator>
+    size_t sample_fast(Generator&& gen) const {
+        return sample_<true>(gen);
+    }
+
+    // draws out.size() samples in blocks: indices and acceptance variates of a block are generated first,
+    // then the lookups are resolved in a tight loop so that independent memory accesses can overlap
+    template <typename Generator>
+    void sample_n(Generator&& gen, std::span<size_t> out) const {
+        constexpr size_t B = 64;
+        std::uniform_int_distribution<size_t> entry_dist(0, R_.size() + P_.size() - 1);
+        std::array<size_t, B> entries;
+        std::array<typename Layout::Variate, B> variates;
+        size_t filled = 0;
+        while (filled < out.size()) {
+            size_t b = std::min(B, out.size() - filled);
+            for (size_t k = 0; k < b; ++k) entries[k] = entry_dist(gen);
+            for (size_t k = 0; k < b; ++k) variates[k] = Layout::variate(gen);
+            for (size_t k = 0; k < b; ++k) {
+                size_t i = entries[k];
+                if (i < R_.size()) {
+                    out[filled] = i;
+                    filled += variates[k] < R_[i];
+                } else {
+                    out[filled] = P_[i - R_.size()];
+                    filled++;
+                }
+            }
+        }
+    }
+
+    // in bytes, excluding the object itself
+    size_t memory_usage() const {
+        return R_.capacity() * sizeof(Threshold) + P_.capacity() * sizeof(Index);
+    }
+
+    // writes R_ and P_ in the format read by MappedProposalArray, throws std::runtime_error on failure
+    void save(const std::string& path) const {
+        OutputFile file(path);
+        auto header = FileHeader::make<Layout>(FileKind::ProposalArray, R_.size());
+        file.write_all(header, std::span<const Threshold>(R_), std::span<const Index>(P_));
+    }
+
+private:
+    template <bool Fast, typename Generator>
+    size_t sample_(Generator&& gen) const {
+        std::uniform_int_distribution<size_t> entry_dist(0, R_.size() + P_.size() - 1);
         do {
-            auto i = entry_dist_(gen);
+            uint64_t bits;
+            size_t i;
+            if constexpr (Fast) i = multiply_shift(random_word(gen), R_.size() + P_.size(), bits);
+            else i = entry_dist(gen);
             if (i < R_.size()) {
-                double p_acc = R_[i];
-                if (real_dist_(gen) < p_acc) {
+                auto p_acc = R_[i];
+                bool accepted;
+                if constexpr (Fast) accepted = Layout::accept_bits(bits, p_acc);
+                else accepted = Layout::variate(gen) < p_acc;
+                if (accepted) {
                     return i;
                 }
             } else {
@@ -41,11 +127,8 @@ public:
         } while (true);
     }
 
-private:
-    std::vector<double> R_;
-    std::vector<size_t> P_;
-    std::uniform_int_distribution<size_t> entry_dist_;
-    std::uniform_real_distribution<double> real_dist_;
+    AllocatedVector<Threshold, Allocator> R_;
+    AllocatedVector<Index, Allocator> P_;
 };
 
-}
\ No newline at end of file
+}
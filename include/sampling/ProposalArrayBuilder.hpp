@@ -0,0 +1,73 @@
+#pragma once
+#include <cmath>
+#include <fstream>
+#include <limits>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <sampling/Layout.hpp>
+#include <sampling/MappedFile.hpp>
+
+namespace sampling {
+
+namespace detail {
+
+// calls f(chunk) for consecutive chunks of the native doubles in the file
+template <typename F>
+void for_each_weight_chunk(const std::string& path, size_t chunk, F&& f) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in) throw std::runtime_error("cannot open weight file '" + path + "'");
+    std::vector<double> buffer(chunk);
+    while (in) {
+        in.read(reinterpret_cast<char*>(buffer.data()), chunk * sizeof(double));
+        size_t bytes = in.gcount();
+        if (bytes % sizeof(double) != 0) throw std::runtime_error("truncated weight file '" + path + "'");
+        if (bytes > 0) f(std::span<const double>(buffer.data(), bytes / sizeof(double)));
+    }
+    if (!in.eof()) throw std::runtime_error("cannot read weight file '" + path + "'");
+}
+
+}
+
+// Builds the file of ProposalArray<Layout>(weights).save(output_path) from a file of native doubles without holding
+// the weights or the arrays in memory. The first pass sums the weights, the second writes R_ and P_ sequentially
+// to their offsets in the output, whose header is written last. Memory usage is O(chunk).
+template <typename Layout = WideLayout>
+void build_proposal_array(const std::string& weights_path, const std::string& output_path, size_t chunk = 1 << 20) {
+    using Index = typename Layout::Index;
+    using Threshold = typename Layout::Threshold;
+    size_t N = 0;
+    double W = 0;
+    detail::for_each_weight_chunk(weights_path, chunk, [&](std::span<const double> weights) {
+        for (double weight : weights) W += weight;
+        N += weights.size();
+    });
+    if (N == 0) throw std::runtime_error("empty weight file '" + weights_path + "'");
+    if (N > std::numeric_limits<Index>::max()) throw std::runtime_error("too many weights for the layout");
+    double avg = W / N;
+
+    OutputFile file(output_path);
+    auto header = FileHeader::make<Layout>(FileKind::ProposalArray, N);
+    header.arrays[0].offset = FileHeader::align(sizeof(FileHeader));
+    header.arrays[1].offset = FileHeader::align(header.arrays[0].offset + N * sizeof(Threshold));
+    ArrayWriter<Threshold> R(file, header.arrays[0].offset, chunk);
+    ArrayWriter<Index> P(file, header.arrays[1].offset, chunk);
+    size_t i = 0;
+    detail::for_each_weight_chunk(weights_path, chunk, [&](std::span<const double> weights) {
+        for (double weight : weights) {
+            size_t count = std::floor(weight / avg);
+            R.push_back(Layout::to_threshold((weight / avg) - count));
+            for (size_t c = 0; c < count; ++c) P.push_back(static_cast<Index>(i));
+            i++;
+        }
+    });
+    if (i != N) throw std::runtime_error("weight file '" + weights_path + "' changed while building");
+    R.flush();
+    P.flush();
+    header.arrays[0].count = R.size();
+    header.arrays[1].count = P.size();
+    file.write(0, &header, sizeof(header));
+}
+
+}
@@ -0,0 +1,25 @@
+#pragma once
+#include <cstdint>
+#include <limits>
+#include <type_traits>
+
+namespace sampling {
+
+// draws a uniform 64-bit word, the generator must produce full 64-bit words (e.g. std::mt19937_64)
+template <typename Generator>
+uint64_t random_word(Generator&& gen) {
+    using G = std::remove_reference_t<Generator>;
+    static_assert(G::min() == 0 && G::max() == std::numeric_limits<uint64_t>::max());
+    return gen();
+}
+
+// Lemire's multiply-shift: maps a uniform 64-bit word to [0, range) and returns the low half of the product
+// in rest, which is close to uniform and independent of the result as long as range is much smaller than 2^64.
+// There is no rejection step, so results are biased by at most range / 2^64.
+inline size_t multiply_shift(uint64_t word, uint64_t range, uint64_t& rest) {
+    __uint128_t m = static_cast<__uint128_t>(word) * range;
+    rest = static_cast<uint64_t>(m);
+    return static_cast<size_t>(m >> 64);
+}
+
+}
@@ -0,0 +1,67 @@
+#pragma once
+#include <memory>
+#include <thread>
+#include <vector>
+#include <sampling/Numa.hpp>
+#include <sampling/ProposalArray.hpp>
+
+namespace sampling {
+
+// One replica of Sampler per NUMA node, each constructed by a thread pinned to its node, so that the replica's arrays
+// are first touched and thus placed there under the default local allocation policy. sample uses the replica of the
+// calling thread's node, see NumaTopology::thread_node, so sampling threads pinned to a node only read local memory.
+// Updates, pushes and pops are applied to every replica in turn by the calling thread and must not run
+// concurrently with sampling, as for Sampler itself; memory they allocate while growing a replica is placed on the
+// caller's node. Requires Sampler::sample to be const.
+template <typename Sampler = ProposalArray<>>
+class ReplicatedSampler {
+public:
+    template <typename Weight>
+    ReplicatedSampler(const std::vector<Weight>& weights) : replicas_(NumaTopology::instance().nodes()) {
+        const NumaTopology& topology = NumaTopology::instance();
+        std::vector<std::thread> builders;
+        for (size_t node = 0; node < replicas_.size(); ++node) {
+            builders.emplace_back([&, node] {
+                topology.pin_to_node(node);
+                replicas_[node] = std::make_unique<Sampler>(weights);
+            });
+        }
+        for (auto& builder : builders) builder.join();
+    }
+
+    template <typename Generator>
+    size_t sample(Generator&& gen) const {
+        return local().sample(gen);
+    }
+
+    template <typename Weight>
+    void update(size_t i, Weight w) {
+        for (auto& replica : replicas_) replica->update(i, w);
+    }
+
+    template <typename Weight>
+    size_t push(Weight w) {
+        size_t i = 0;
+        for (auto& replica : replicas_) i = replica->push(w);
+        return i;
+    }
+
+    void pop() {
+        for (auto& replica : replicas_) replica->pop();
+    }
+
+    size_t replicas() const {
+        return replicas_.size();
+    }
+
+    // replica of the calling thread's node; threads sampling in a hot loop can take it once, which saves the lookup
+    // per sample and lets the compiler keep the replica's bounds in registers
+    const Sampler& local() const {
+        return *replicas_[NumaTopology::instance().thread_node()];
+    }
+
+private:
+    std::vector<std::unique_ptr<Sampler>> replicas_;
+};
+
+}
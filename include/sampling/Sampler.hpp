@@ -0,0 +1,28 @@
+#pragma once
+#include <concepts>
+#include <cstddef>
+#include <random>
+
+namespace sampling {
+
+// draws an index with probability proportional to its weight
+template <typename S, typename Generator = std::mt19937_64>
+concept Sampler = requires(S& s, Generator& gen) {
+    { s.sample(gen) } -> std::convertible_to<size_t>;
+};
+
+// draws through a const reference, so threads with their own generators can share one instance without locking
+template <typename S, typename Generator = std::mt19937_64>
+concept SharedSampler = Sampler<S, Generator> && requires(const S& s, Generator& gen) {
+    { s.sample(gen) } -> std::convertible_to<size_t>;
+};
+
+// additionally changes single weights and appends or removes weights at the back
+template <typename S, typename Generator = std::mt19937_64>
+concept DynamicSampler = Sampler<S, Generator> && requires(S& s, size_t i, double w) {
+    s.update(i, w);
+    { s.push(w) } -> std::convertible_to<size_t>;
+    s.pop();
+};
+
+}
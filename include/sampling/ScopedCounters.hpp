@@ -0,0 +1,192 @@
+#pragma once
+#ifndef SCOPED_COUNTERS_HPP
+#define SCOPED_COUNTERS_HPP
+
+#include <array>
+#include <cerrno>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <limits>
+#include <string>
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace tools {
+
+// Hardware performance counters of the calling thread and the threads it starts, read through perf_event_open.
+// Counting is opt-in by setting SAMPLING_PERF_COUNTERS in the environment; without it, or if the kernel or the
+// machine provides none of the counters, every ScopedCounters is a no-op that prints nothing.
+class PerfCounters {
+public:
+    static constexpr size_t _events = 5;
+
+    struct Reading {
+        std::array<uint64_t, _events> value;
+        std::array<uint64_t, _events> enabled;
+        std::array<uint64_t, _events> running;
+    };
+
+    using Counts = std::array<double, _events>;
+
+    static const std::array<const char *, _events> &names() {
+        static const std::array<const char *, _events> names = {"cycles", "instructions", "llc-misses", "dtlb-misses",
+                                                                 "branch-misses"};
+        return names;
+    }
+
+    static PerfCounters &instance() {
+        static PerfCounters counters;
+        return counters;
+    }
+
+    bool active() const {
+        return _active;
+    }
+
+    bool available(size_t e) const {
+        return _fds[e] >= 0;
+    }
+
+    Reading read() const {
+        Reading r = {};
+        for (size_t e = 0; e < _events; ++e) {
+            uint64_t data[3];
+            if (_fds[e] >= 0 && ::read(_fds[e], data, sizeof(data)) == sizeof(data)) {
+                r.value[e] = data[0];
+                r.enabled[e] = data[1];
+                r.running[e] = data[2];
+            }
+        }
+        return r;
+    }
+
+private:
+    PerfCounters() : _active(false) {
+        _fds.fill(-1);
+        const char *env = std::getenv("SAMPLING_PERF_COUNTERS");
+        if (!env || !*env || std::strcmp(env, "0") == 0)
+            return;
+        const std::array<std::pair<uint32_t, uint64_t>, _events> events = {{
+            {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES},
+            {PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS},
+            {PERF_TYPE_HW_CACHE, cache(PERF_COUNT_HW_CACHE_LL)},
+            {PERF_TYPE_HW_CACHE, cache(PERF_COUNT_HW_CACHE_DTLB)},
+            {PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES},
+        }};
+        int error = 0;
+        for (size_t e = 0; e < _events; ++e) {
+            perf_event_attr attr = {};
+            attr.size = sizeof(attr);
+            attr.type = events[e].first;
+            attr.config = events[e].second;
+            attr.exclude_kernel = 1;
+            attr.exclude_hv = 1;
+            attr.inherit = 1;
+            attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+            _fds[e] = static_cast<int>(::syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+            if (_fds[e] < 0)
+                error = errno;
+            else
+                _active = true;
+        }
+        if (!_active)
+            std::cerr << "SAMPLING_PERF_COUNTERS is set but no counters are available: " << std::strerror(error)
+                      << std::endl;
+    }
+
+    ~PerfCounters() {
+        for (int fd : _fds)
+            if (fd >= 0)
+                ::close(fd);
+    }
+
+    static uint64_t cache(uint64_t cache) {
+        return cache | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+    }
+
+    std::array<int, _events> _fds;
+    bool _active;
+};
+
+// Counts events over its scope and reports them per operation on a line of its own, starting with "Counters" so
+// that it is told apart from the timing lines, or adds them to an output like ScopedTimer(double &). Counters are
+// never reset, so scopes may nest.
+class ScopedCounters {
+    std::string _prefix;
+    uint64_t _ops;
+    PerfCounters::Counts *_output;
+    PerfCounters::Reading _begin;
+
+public:
+    ScopedCounters() : _ops(1), _output(nullptr) {
+        if (PerfCounters::instance().active())
+            _begin = PerfCounters::instance().read();
+    }
+
+    ScopedCounters(const std::string &prefix, uint64_t ops = 1) : _prefix(prefix), _ops(ops), _output(nullptr) {
+        if (PerfCounters::instance().active())
+            _begin = PerfCounters::instance().read();
+    }
+
+    ScopedCounters(PerfCounters::Counts &output) : _ops(1), _output(&output) {
+        if (PerfCounters::instance().active())
+            _begin = PerfCounters::instance().read();
+    }
+
+    ~ScopedCounters() {
+        if (!PerfCounters::instance().active())
+            return;
+        PerfCounters::Counts counts = elapsed();
+        if (_output) {
+            for (size_t e = 0; e < PerfCounters::_events; ++e)
+                (*_output)[e] += counts[e];
+        }
+        if (!_prefix.empty())
+            report(_prefix, counts, _ops);
+    }
+
+    // events since construction, NaN for the ones that are not available
+    PerfCounters::Counts elapsed() const {
+        const PerfCounters &counters = PerfCounters::instance();
+        PerfCounters::Reading end = counters.read();
+        PerfCounters::Counts counts;
+        for (size_t e = 0; e < PerfCounters::_events; ++e) {
+            uint64_t running = end.running[e] - _begin.running[e];
+            if (!counters.available(e) || running == 0) {
+                counts[e] = std::numeric_limits<double>::quiet_NaN();
+                continue;
+            }
+            // scale up for the time the counter was multiplexed out
+            double enabled = static_cast<double>(end.enabled[e] - _begin.enabled[e]);
+            counts[e] = static_cast<double>(end.value[e] - _begin.value[e]) * enabled / running;
+        }
+        return counts;
+    }
+
+    void report(const std::string &prefix, uint64_t ops) const {
+        report(prefix, elapsed(), ops);
+    }
+
+    static void report(const std::string &prefix, const PerfCounters::Counts &counts, uint64_t ops) {
+        if (!PerfCounters::instance().active())
+            return;
+        std::cout << "Counters " << prefix;
+        for (size_t e = 0; e < PerfCounters::_events; ++e) {
+            std::cout << " " << PerfCounters::names()[e] << ": ";
+            if (std::isnan(counts[e]))
+                std::cout << "n/a";
+            else
+                std::cout << counts[e] / (ops ? ops : 1);
+        }
+        std::cout << " per op" << std::endl;
+    }
+};
+
+}
+
+#endif
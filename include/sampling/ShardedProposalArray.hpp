@@ -0,0 +1,95 @@
+#pragma once
+#include <atomic>
+#include <cassert>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <shared_mutex>
+#include <vector>
+#include <sampling/DynamicProposalArray.hpp>
+
+namespace sampling {
+
+// Splits the index space round-robin into T shards, global index i lives at local index i / T of shard i % T.
+// Every shard is a DynamicProposalArray behind its own readers-writer lock, so updates only contend within a shard
+// and samples only with updates of the sampled shard. The top level picks a shard by a scan over the shard totals,
+// which are published atomically after every update; T is meant to be about the number of threads.
+// push and pop must not run concurrently with each other, and every shard keeps at least one element.
+template <typename Layout = WideLayout, typename Weight = double, typename Allocator = std::allocator<std::byte>>
+class ShardedProposalArray {
+    struct alignas(64) Shard {
+        Shard(const std::vector<Weight>& weights) : pa(weights), total(pa.total_weight()) {}
+
+        DynamicProposalArray<Layout, Weight, Allocator> pa;
+        mutable std::shared_mutex mutex;
+        std::atomic<double> total;
+    };
+public:
+    ShardedProposalArray(const std::vector<Weight>& weights, size_t shards) : N_(weights.size()) {
+        assert(shards > 0 && weights.size() >= shards);
+        for (size_t s = 0; s < shards; ++s) {
+            std::vector<Weight> local;
+            for (size_t i = s; i < weights.size(); i += shards) local.push_back(weights[i]);
+            shards_.push_back(std::make_unique<Shard>(local));
+        }
+    }
+
+    template <typename Generator>
+    size_t sample(Generator&& gen) const {
+        size_t T = shards_.size();
+        double W = 0;
+        for (auto& shard : shards_) W += shard->total.load(std::memory_order_relaxed);
+        std::uniform_real_distribution<double> real_dist(0, W);
+        double x = real_dist(gen);
+        size_t s = 0;
+        for (; s + 1 < T; ++s) {
+            double total = shards_[s]->total.load(std::memory_order_relaxed);
+            if (x < total) break;
+            x -= total;
+        }
+        std::shared_lock lock(shards_[s]->mutex);
+        return shards_[s]->pa.sample(gen) * T + s;
+    }
+
+    void update(size_t i, Weight w) {
+        Shard& shard = *shards_[shard_of(i)];
+        std::unique_lock lock(shard.mutex);
+        shard.pa.update(i / shards_.size(), w);
+        shard.total.store(shard.pa.total_weight(), std::memory_order_relaxed);
+    }
+
+    size_t push(Weight w) {
+        size_t i = N_.load();
+        Shard& shard = *shards_[shard_of(i)];
+        std::unique_lock lock(shard.mutex);
+        shard.pa.push(w);
+        shard.total.store(shard.pa.total_weight(), std::memory_order_relaxed);
+        N_.store(i + 1);
+        return i;
+    }
+
+    void pop() {
+        size_t i = N_.load() - 1;
+        Shard& shard = *shards_[shard_of(i)];
+        std::unique_lock lock(shard.mutex);
+        assert(shard.pa.size() > 1);
+        shard.pa.pop();
+        shard.total.store(shard.pa.total_weight(), std::memory_order_relaxed);
+        N_.store(i);
+    }
+
+    // updates of indices in the same shard should come from the same thread
+    size_t shard_of(size_t i) const {
+        return i % shards_.size();
+    }
+
+    size_t shards() const {
+        return shards_.size();
+    }
+
+private:
+    std::vector<std::unique_ptr<Shard>> shards_;
+    std::atomic<size_t> N_;
+};
+
+}
@@ -0,0 +1,120 @@
+#pragma once
+#include <algorithm>
+#include <cassert>
+#include <memory>
+#include <vector>
+#include <sampling/Allocator.hpp>
+
+namespace sampling {
+
+// Variable-length lists stored in one flat arena instead of one heap allocation per list. Each list occupies a
+// contiguous range of slots with slack. A list that outgrows its range moves to the end of the arena with doubled
+// capacity and leaves its old range unused; once the unused slots outnumber the owned ones, the arena is compacted
+// and the slack is dropped, so push_back and pop_back take amortized O(1) time.
+template <typename T, typename Size = size_t, typename Allocator = std::allocator<T>>
+class SlotArena {
+    struct Range {
+        size_t offset;
+        Size size;
+        Size capacity;
+    };
+public:
+    // n empty lists in an arena of the given number of slots, which must then be tiled by the lists via place
+    void reset(size_t n, size_t slots) {
+        ranges_.assign(n, Range{0, 0, 0});
+        slots_.assign(slots, T());
+        unused_ = 0;
+    }
+
+    // lays out list i in slots [offset, offset + capacity) with its first size slots in use, may be called
+    // concurrently for different lists
+    void place(size_t i, size_t offset, size_t size, size_t capacity) {
+        assert(ranges_[i].capacity == 0 && size <= capacity && offset + capacity <= slots_.size());
+        ranges_[i] = Range{offset, static_cast<Size>(size), static_cast<Size>(capacity)};
+    }
+
+    void place(size_t i, size_t offset, size_t size) {
+        place(i, offset, size, size);
+    }
+
+    size_t lists() const {
+        return ranges_.size();
+    }
+
+    size_t size(size_t i) const {
+        return ranges_[i].size;
+    }
+
+    T& operator()(size_t i, size_t k) {
+        assert(k < ranges_[i].size);
+        return slots_[ranges_[i].offset + k];
+    }
+
+    const T& operator()(size_t i, size_t k) const {
+        assert(k < ranges_[i].size);
+        return slots_[ranges_[i].offset + k];
+    }
+
+    T& back(size_t i) {
+        return (*this)(i, ranges_[i].size - 1);
+    }
+
+    void push_back(size_t i, T value) {
+        if (ranges_[i].size == ranges_[i].capacity) grow(i);
+        Range& r = ranges_[i];
+        slots_[r.offset + r.size] = value;
+        r.size++;
+    }
+
+    void pop_back(size_t i) {
+        assert(ranges_[i].size > 0);
+        ranges_[i].size--;
+    }
+
+    void push_list() {
+        ranges_.push_back(Range{slots_.size(), 0, 0});
+    }
+
+    void pop_list() {
+        assert(ranges_.size() > 0);
+        unused_ += ranges_.back().capacity;
+        ranges_.pop_back();
+    }
+
+    // in bytes, excluding the object itself
+    size_t memory_usage() const {
+        return ranges_.capacity() * sizeof(Range) + slots_.capacity() * sizeof(T);
+    }
+
+private:
+    void grow(size_t i) {
+        if (unused_ > slots_.size() - unused_ && unused_ > ranges_.size()) compact();
+        Range& r = ranges_[i];
+        size_t capacity = std::max<size_t>(2 * r.capacity, 1);
+        size_t offset = slots_.size();
+        slots_.resize(offset + capacity);
+        std::copy(slots_.begin() + r.offset, slots_.begin() + r.offset + r.size, slots_.begin() + offset);
+        unused_ += r.capacity;
+        r.offset = offset;
+        r.capacity = static_cast<Size>(capacity);
+    }
+
+    void compact() {
+        AllocatedVector<T, Allocator> slots;
+        slots.reserve(slots_.size() - unused_);
+        for (auto& r : ranges_) {
+            size_t offset = slots.size();
+            slots.insert(slots.end(), slots_.begin() + r.offset, slots_.begin() + r.offset + r.size);
+            r.offset = offset;
+            r.capacity = r.size;
+        }
+        slots_.swap(slots);
+        unused_ = 0;
+    }
+
+    AllocatedVector<Range, Allocator> ranges_;
+    AllocatedVector<T, Allocator> slots_;
+    size_t unused_ = 0; // slots not owned by any list
+};
+
+}
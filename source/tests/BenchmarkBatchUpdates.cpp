@@ -0,0 +1,73 @@
+#include <cstdint>
+#include <random>
+#include <sampling/ScopedCounters.hpp>
+#include <sampling/ScopedTimer.hpp>
+#include <sampling/DynamicProposalArray.hpp>
+
+using namespace sampling;
+
+std::vector<std::pair<size_t, double>> generate_burst(std::vector<double>& weights, size_t b, std::mt19937_64& gen) {
+    std::uniform_real_distribution<double> weight_dist(0, weights.size());
+    std::uniform_int_distribution<size_t> index_dist(0, weights.size() - 1);
+    std::vector<std::pair<size_t, double>> burst;
+    burst.reserve(b);
+    for (size_t s = 0; s < b; ++s) {
+        size_t i = index_dist(gen);
+        weights[i] += weight_dist(gen);
+        burst.emplace_back(i, weights[i]);
+    }
+    return burst;
+}
+
+void benchmark_bursts(size_t n, size_t b, size_t updates, std::mt19937_64& gen) {
+    std::uniform_real_distribution<double> weight_dist(0, n);
+    std::vector<double> weights;
+    for (size_t i = 0; i < n; ++i) weights.push_back(weight_dist(gen));
+    std::vector<double> batched_weights = weights;
+    DynamicProposalArray pa(weights);
+    DynamicProposalArray batched_pa(batched_weights);
+    double time = 0;
+    double batched_time = 0;
+    tools::PerfCounters::Counts counts = {};
+    tools::PerfCounters::Counts batched_counts = {};
+    for (size_t t = 0; t < updates; t += b) {
+        auto burst = generate_burst(weights, b, gen);
+        double elapsed;
+        {
+            tools::ScopedCounters counters(counts);
+            tools::ScopedTimer timer(elapsed);
+            for (auto [i, w] : burst) pa.update(i, w);
+        }
+        time += elapsed;
+        {
+            tools::ScopedCounters counters(batched_counts);
+            tools::ScopedTimer timer(elapsed);
+            batched_pa.update_many(burst);
+        }
+        batched_time += elapsed;
+    }
+    std::cout << "ProposalArray Burst [n: " << b << "] Time elapsed: " << (1e3 * time) << "ms / " << updates
+              << " = " << (1e6 * time / updates) << "us" << std::endl;
+    std::cout << "ProposalArrayBatched Burst [n: " << b << "] Time elapsed: " << (1e3 * batched_time) << "ms / "
+              << updates << " = " << (1e6 * batched_time / updates) << "us" << std::endl;
+    tools::ScopedCounters::report("ProposalArray Burst [n: " + std::to_string(b) + "]", counts, updates);
+    tools::ScopedCounters::report("ProposalArrayBatched Burst [n: " + std::to_string(b) + "]", batched_counts, updates);
+}
+
+int main() {
+    std::random_device rd;
+    size_t seed = rd();
+    std::mt19937_64 gen(seed);
+
+    size_t n = 10000000;
+    size_t updates = 10 * n;
+    size_t repeats = 5;
+
+    for (size_t r = 0; r < repeats; ++r) {
+        for (size_t b = 100; b <= 1000000; b *= 10) {
+            benchmark_bursts(n, b, updates, gen);
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,80 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <random>
+#include <thread>
+#include <sampling/ConcurrentSampler.hpp>
+#include <sampling/ScopedCounters.hpp>
+
+using namespace sampling;
+
+// readers sample for the given duration while one writer applies random increases at the given rate (0 = unthrottled)
+template <typename Algo>
+void benchmark_readers(size_t n, size_t readers, double rate, double seconds, std::string name, std::mt19937_64& gen) {
+    std::uniform_real_distribution<double> weight_dist(0, n);
+    std::vector<double> weights;
+    for (size_t i = 0; i < n; ++i) weights.push_back(weight_dist(gen));
+    Algo ds(weights);
+    std::atomic<bool> stop{false};
+    std::atomic<size_t> samples{0};
+    size_t updates = 0;
+    tools::ScopedCounters counters;
+    std::vector<std::thread> threads;
+    for (size_t r = 0; r < readers; ++r) {
+        threads.emplace_back([&, seed = gen()] {
+            std::mt19937_64 reader_gen(seed);
+            size_t count = 0;
+            while (!stop.load(std::memory_order_relaxed)) {
+                for (size_t s = 0; s < 1000; ++s) {
+                    [[maybe_unused]] volatile size_t sample = ds.sample(reader_gen);
+                }
+                count += 1000;
+            }
+            samples += count;
+        });
+    }
+    std::thread writer([&] {
+        std::uniform_int_distribution<size_t> index_dist(0, n - 1);
+        auto begin = std::chrono::steady_clock::now();
+        while (!stop.load(std::memory_order_relaxed)) {
+            if (rate > 0) {
+                std::this_thread::sleep_until(begin + std::chrono::duration<double>(updates / rate));
+            }
+            size_t i = index_dist(gen);
+            weights[i] += weight_dist(gen);
+            ds.update(i, weights[i]);
+            updates++;
+        }
+    });
+    std::this_thread::sleep_for(std::chrono::duration<double>(seconds));
+    stop = true;
+    writer.join();
+    for (auto& t : threads) t.join();
+    tools::PerfCounters::Counts counts = counters.elapsed();
+    std::cout << name << " Readers [n: " << static_cast<size_t>(rate) << "] Throughput: " << (samples / seconds)
+              << " samples/s, " << (updates / seconds) << " updates/s, " << readers << " readers" << std::endl;
+    // per sample or update, of the readers and the writer together
+    tools::ScopedCounters::report(name + " Readers [n: " + std::to_string(static_cast<size_t>(rate)) + "]", counts,
+                                  samples + updates);
+}
+
+int main() {
+    std::random_device rd;
+    size_t seed = rd();
+    std::mt19937_64 gen(seed);
+
+    size_t n = 10000000;
+    size_t readers = std::max<unsigned>(std::thread::hardware_concurrency(), 2) - 1;
+    double seconds = 5;
+    size_t repeats = 3;
+
+    for (size_t r = 0; r < repeats; ++r) {
+        for (double rate : {1e2, 1e3, 1e4, 1e5, 1e6, 0.0}) {
+            benchmark_readers<ConcurrentSampler<>>(n, readers, rate, seconds, "ConcurrentProposalArray", gen);
+        }
+    }
+
+    return 0;
+}
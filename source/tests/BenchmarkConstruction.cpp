@@ -1,9 +1,15 @@
 #include <cstdint>
+#include <filesystem>
 #include <numbers>
 #include <random>
+#include <thread>
+#include <sampling/ScopedCounters.hpp>
 #include <sampling/ScopedTimer.hpp>
 #include <sampling/AliasTable.hpp>
 #include <sampling/ProposalArray.hpp>
+#include <sampling/DynamicProposalArray.hpp>
+#include <sampling/MappedAliasTable.hpp>
+#include <sampling/MappedProposalArray.hpp>
 
 using namespace sampling;
 
@@ -51,17 +57,70 @@ std::vector<double> generate_noisy_delta_weights(size_t n, std::mt19937_64& gen)
 }
 
 void benchmark_at_construction(const std::vector<double>& weights, std::string name) {
-    tools::ScopedTimer timer("AliasTable " + name + " [n: " + std::to_string(weights.size()) + "]");
+    std::string prefix = "AliasTable " + name + " [n: " + std::to_string(weights.size()) + "]";
+    tools::ScopedCounters counters(prefix, weights.size());
+    tools::ScopedTimer timer(prefix);
     AliasTable at(weights);
 }
 
 void benchmark_pa_construction(const std::vector<double>& weights, std::string name) {
-    tools::ScopedTimer timer("ProposalArray " + name + " [n: " + std::to_string(weights.size()) + "]");
+    std::string prefix = "ProposalArray " + name + " [n: " + std::to_string(weights.size()) + "]";
+    tools::ScopedCounters counters(prefix, weights.size());
+    tools::ScopedTimer timer(prefix);
     ProposalArray pa(weights);
 }
 
+void benchmark_dpa_construction(const std::vector<double>& weights, std::string name) {
+    std::string prefix = "DynamicProposalArray " + name + " [n: " + std::to_string(weights.size()) + "]";
+    tools::ScopedCounters counters(prefix, weights.size());
+    tools::ScopedTimer timer(prefix);
+    DynamicProposalArray dpa(weights);
+}
+
+void benchmark_at_parallel_construction(const std::vector<double>& weights, size_t threads, std::string name) {
+    std::string prefix = "AliasTableParallel " + name + " [n: " + std::to_string(weights.size()) + "] [threads: "
+                         + std::to_string(threads) + "]";
+    tools::ScopedCounters counters(prefix, weights.size());
+    tools::ScopedTimer timer(prefix);
+    AliasTable at(weights, threads);
+}
+
+void benchmark_pa_parallel_construction(const std::vector<double>& weights, size_t threads, std::string name) {
+    std::string prefix = "ProposalArrayParallel " + name + " [n: " + std::to_string(weights.size()) + "] [threads: "
+                         + std::to_string(threads) + "]";
+    tools::ScopedCounters counters(prefix, weights.size());
+    tools::ScopedTimer timer(prefix);
+    ProposalArray pa(weights, threads);
+}
+
+void benchmark_dpa_parallel_construction(const std::vector<double>& weights, size_t threads, std::string name) {
+    std::string prefix = "DynamicProposalArrayParallel " + name + " [n: " + std::to_string(weights.size()) + "] [threads: "
+                         + std::to_string(threads) + "]";
+    tools::ScopedCounters counters(prefix, weights.size());
+    tools::ScopedTimer timer(prefix);
+    DynamicProposalArray dpa(weights, threads);
+}
+
+// saves the built structure, then measures opening the mapping and the first sample, which faults in its pages
+template <typename Built, typename View>
+void benchmark_load(const std::vector<double>& weights, std::mt19937_64& gen, std::string algo, std::string name) {
+    std::string path = std::filesystem::temp_directory_path() / "sampling_benchmark.bin";
+    Built(weights).save(path);
+    std::string suffix = " " + name + " [n: " + std::to_string(weights.size()) + "]";
+    tools::ScopedTimer timer;
+    View view(path);
+    timer.report(algo + "Load" + suffix);
+    timer.start();
+    volatile size_t sample = view.sample(gen);
+    timer.report(algo + "FirstSample" + suffix);
+    static_cast<void>(sample);
+    std::filesystem::remove(path);
+}
+
 void benchmark_dd_construction(const std::vector<double>& weights, std::string name) {
-    tools::ScopedTimer timer("DiscreteDistribution " + name + " [n: " + std::to_string(weights.size()) + "]");
+    std::string prefix = "DiscreteDistribution " + name + " [n: " + std::to_string(weights.size()) + "]";
+    tools::ScopedCounters counters(prefix, weights.size());
+    tools::ScopedTimer timer(prefix);
     std::discrete_distribution dd(weights.begin(), weights.end());
 }
 
@@ -72,6 +131,11 @@ int main() {
 
     std::vector<size_t> ns = {100000, 1000000, 10000000, 100000000};
     size_t repeats = 1;
+    // powers of two up to all cores
+    size_t max_threads = std::max<unsigned>(std::thread::hardware_concurrency(), 1);
+    std::vector<size_t> thread_counts;
+    for (size_t threads = 1; threads < max_threads; threads *= 2) thread_counts.push_back(threads);
+    thread_counts.push_back(max_threads);
 
     for (auto n : ns) {
         for (size_t r = 0; r < repeats; ++r) {
@@ -83,6 +147,14 @@ int main() {
             for (auto [weights, name] : weights_names) {
                 benchmark_at_construction(weights, name);
                 benchmark_pa_construction(weights, name);
+                benchmark_dpa_construction(weights, name);
+                benchmark_load<AliasTable<>, MappedAliasTable<>>(weights, gen, "AliasTable", name);
+                benchmark_load<ProposalArray<>, MappedProposalArray<>>(weights, gen, "ProposalArray", name);
+                for (size_t threads : thread_counts) {
+                    benchmark_at_parallel_construction(weights, threads, name);
+                    benchmark_pa_parallel_construction(weights, threads, name);
+                    benchmark_dpa_parallel_construction(weights, threads, name);
+                }
             }
         }
     }
@@ -0,0 +1,385 @@
+#include <cstdint>
+#include <ctime>
+#include <fstream>
+#include <iostream>
+#include <numbers>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <vector>
+#include <sys/utsname.h>
+#include <unistd.h>
+#include <sampling/ScopedTimer.hpp>
+#include <sampling/AliasTable.hpp>
+#include <sampling/ProposalArray.hpp>
+#include <sampling/DynamicProposalArray.hpp>
+#include <sampling/DynamicProposalArrayStar.hpp>
+#include <sampling/LogCascade.hpp>
+#include <sampling/BinaryTree.hpp>
+#include <sampling/Parallel.hpp>
+
+using namespace sampling;
+
+// Runs one structure, weight distribution and workload with the parameters given on the command line and prints one
+// row per repetition as CSV or JSON together with a description of the machine and the build. All randomness is
+// derived from --seed, so two runs with the same arguments on the same build sample the same weights and indices.
+
+const char* usage =
+    "usage: BenchmarkDriver [--structure S] [--distribution D] [--workload W] [--n N] [--operations K]\n"
+    "                       [--repeats R] [--seed X] [--threads T] [--format csv|json]\n"
+    "  structures:    AliasTable, AliasTableCompact, ProposalArray, ProposalArrayCompact, DynamicProposalArray,\n"
+    "                 DynamicProposalArrayCompact, DynamicProposalArrayStar, LogCascade, LogCascade2, BinaryTree,\n"
+    "                 BinaryTree4, BinaryTree8, BinaryTree16, DiscreteDistribution\n"
+    "  distributions: NoisyUniform, PowerLaw, NoisyDelta\n"
+    "  workloads:     Construction, Sampling, RandomIncrease, PolyaUrn, SingleIncrease, Insertion, Removal\n";
+
+struct Config {
+    std::string structure = "ProposalArray";
+    std::string distribution = "NoisyUniform";
+    std::string workload = "Sampling";
+    std::string format = "csv";
+    size_t n = 1000000;
+    size_t operations = 1000000; // samples, updates, pushes or pops per repetition
+    size_t repeats = 5;
+    size_t threads = 1;
+    uint64_t seed = 1;
+};
+
+struct Row {
+    size_t repeat;
+    size_t operations;
+    double seconds;
+};
+
+Config parse_arguments(int argc, char** argv) {
+    Config config;
+    for (int a = 1; a < argc; ++a) {
+        std::string arg = argv[a];
+        if (arg == "--help" || arg == "-h") {
+            std::cout << usage;
+            std::exit(0);
+        }
+        std::string value;
+        size_t eq = arg.find('=');
+        if (eq != std::string::npos) {
+            value = arg.substr(eq + 1);
+            arg = arg.substr(0, eq);
+        } else if (a + 1 < argc) {
+            value = argv[++a];
+        } else {
+            throw std::invalid_argument("missing value for " + arg);
+        }
+        auto number = [&] {
+            size_t end;
+            unsigned long long x = std::stoull(value, &end);
+            if (end != value.size()) throw std::invalid_argument("invalid number '" + value + "' for " + arg);
+            return static_cast<size_t>(x);
+        };
+        if (arg == "--structure") config.structure = value;
+        else if (arg == "--distribution") config.distribution = value;
+        else if (arg == "--workload") config.workload = value;
+        else if (arg == "--format") config.format = value;
+        else if (arg == "--n") config.n = number();
+        else if (arg == "--operations") config.operations = number();
+        else if (arg == "--repeats") config.repeats = number();
+        else if (arg == "--threads") config.threads = number();
+        else if (arg == "--seed") config.seed = number();
+        else throw std::invalid_argument("unknown option " + arg);
+    }
+    if (config.format != "csv" && config.format != "json")
+        throw std::invalid_argument("unknown format " + config.format);
+    if (config.n == 0 || config.threads == 0) throw std::invalid_argument("--n and --threads must be positive");
+    return config;
+}
+
+// independent generator for every stream of a run, stream 0 draws the weights
+std::mt19937_64 make_generator(uint64_t seed, uint64_t stream) {
+    std::seed_seq seq{static_cast<uint32_t>(seed), static_cast<uint32_t>(seed >> 32),
+                      static_cast<uint32_t>(stream), static_cast<uint32_t>(stream >> 32)};
+    return std::mt19937_64(seq);
+}
+
+std::vector<double> generate_weights(const std::string& distribution, size_t n, std::mt19937_64& gen) {
+    std::vector<double> weights;
+    weights.reserve(n);
+    if (distribution == "NoisyUniform") {
+        std::uniform_real_distribution<double> weight_dist(0, n);
+        for (size_t i = 0; i < n; ++i) weights.push_back(weight_dist(gen));
+    } else if (distribution == "PowerLaw") {
+        std::uniform_real_distribution<double> real_dist(0, 1);
+        for (size_t i = 0; i < n; ++i) {
+            double C = std::numbers::pi * std::numbers::pi / 6;
+            size_t w = 1;
+            double ww = 1.;
+            while (real_dist(gen) > ww / C) {
+                C -= ww;
+                w++;
+                ww = 1. / (w * w);
+            }
+            weights.push_back(w);
+        }
+    } else if (distribution == "NoisyDelta") {
+        std::uniform_real_distribution<double> weight_dist(0, 1);
+        for (size_t i = 0; i + 1 < n; ++i) weights.push_back(weight_dist(gen));
+        weights.push_back(n);
+    } else {
+        throw std::invalid_argument("unknown distribution " + distribution);
+    }
+    return weights;
+}
+
+// std::discrete_distribution behind the interface of the other structures, as the baseline
+class DiscreteDistribution {
+public:
+    DiscreteDistribution(const std::vector<double>& weights) : dd_(weights.begin(), weights.end()) {}
+
+    template <typename Generator>
+    size_t sample(Generator&& gen) {
+        return dd_(gen);
+    }
+
+private:
+    std::discrete_distribution<size_t> dd_;
+};
+
+// calls f.template operator()<Algo>() for the structure of the given name
+template <typename F>
+void with_structure(const std::string& structure, F&& f) {
+    if (structure == "AliasTable") f.template operator()<AliasTable<>>();
+    else if (structure == "AliasTableCompact") f.template operator()<AliasTable<CompactLayout>>();
+    else if (structure == "ProposalArray") f.template operator()<ProposalArray<>>();
+    else if (structure == "ProposalArrayCompact") f.template operator()<ProposalArray<CompactLayout>>();
+    else if (structure == "DynamicProposalArray") f.template operator()<DynamicProposalArray<>>();
+    else if (structure == "DynamicProposalArrayCompact") f.template operator()<DynamicProposalArray<CompactLayout>>();
+    else if (structure == "DynamicProposalArrayStar") f.template operator()<DynamicProposalArrayStar<>>();
+    else if (structure == "LogCascade") f.template operator()<LogCascade<1>>();
+    else if (structure == "LogCascade2") f.template operator()<LogCascade<2>>();
+    else if (structure == "BinaryTree") f.template operator()<BinaryTree<>>();
+    else if (structure == "BinaryTree4") f.template operator()<BinaryTree<4>>();
+    else if (structure == "BinaryTree8") f.template operator()<BinaryTree<8>>();
+    else if (structure == "BinaryTree16") f.template operator()<BinaryTree<16>>();
+    else if (structure == "DiscreteDistribution") f.template operator()<DiscreteDistribution>();
+    else throw std::invalid_argument("unknown structure " + structure);
+}
+
+std::invalid_argument unsupported(const Config& config) {
+    return std::invalid_argument("structure " + config.structure + " does not support workload " + config.workload
+                                 + (config.threads > 1 ? " with " + std::to_string(config.threads) + " threads" : ""));
+}
+
+template <typename Algo>
+Row run_construction(const Config& config, const std::vector<double>& weights, size_t repeat) {
+    double seconds;
+    if (config.threads > 1) {
+        if constexpr (std::is_constructible_v<Algo, const std::vector<double>&, size_t>) {
+            tools::ScopedTimer timer(seconds);
+            Algo ds(weights, config.threads);
+        } else {
+            throw unsupported(config);
+        }
+    } else {
+        tools::ScopedTimer timer(seconds);
+        Algo ds(weights);
+    }
+    return {repeat, weights.size(), seconds};
+}
+
+// each thread draws its share of the samples with its own generator from the same structure, which therefore needs
+// a const sample
+template <typename Algo>
+Row run_sampling(const Config& config, const std::vector<double>& weights, size_t repeat) {
+    Algo ds(weights);
+    double seconds;
+    if (config.threads > 1) {
+        if constexpr (requires(const Algo& cds, std::mt19937_64& gen) { cds.sample(gen); }) {
+            const Algo& cds = ds;
+            tools::ScopedTimer timer(seconds);
+            parallel_for(config.threads, config.operations, [&](size_t t, size_t begin, size_t end) {
+                std::mt19937_64 gen = make_generator(config.seed, 1 + repeat * config.threads + t);
+                for (size_t s = begin; s < end; ++s) {
+                    [[maybe_unused]] volatile size_t sample = cds.sample(gen);
+                }
+            });
+        } else {
+            throw unsupported(config);
+        }
+    } else {
+        std::mt19937_64 gen = make_generator(config.seed, 1 + repeat);
+        tools::ScopedTimer timer(seconds);
+        for (size_t s = 0; s < config.operations; ++s) {
+            [[maybe_unused]] volatile size_t sample = ds.sample(gen);
+        }
+    }
+    return {repeat, config.operations, seconds};
+}
+
+template <typename Algo>
+Row run_dynamic(const Config& config, std::vector<double> weights, size_t repeat) {
+    constexpr bool updates = requires(Algo& ds) { ds.update(size_t(0), 0.0); };
+    constexpr bool resizes = requires(Algo& ds) { ds.push(0.0); ds.pop(); };
+    const std::string& workload = config.workload;
+    bool insertion = workload == "Insertion" || workload == "Removal";
+    if (config.threads > 1 || (insertion && !resizes) || (!insertion && !updates)) throw unsupported(config);
+    size_t n = weights.size();
+    std::mt19937_64 gen = make_generator(config.seed, 1 + repeat);
+    std::uniform_real_distribution<double> weight_dist(0, n);
+    std::uniform_int_distribution<size_t> index_dist(0, n - 1);
+    // removal pops the extra elements that construction received on top of the n ones
+    if (workload == "Removal") {
+        for (size_t i = 0; i < config.operations; ++i) weights.push_back(weight_dist(gen));
+    }
+    Algo ds(weights);
+    double seconds;
+    {
+        tools::ScopedTimer timer(seconds);
+        if constexpr (updates) {
+            if (workload == "RandomIncrease") {
+                for (size_t s = 0; s < config.operations; ++s) {
+                    size_t i = index_dist(gen);
+                    weights[i] += weight_dist(gen);
+                    ds.update(i, weights[i]);
+                }
+            } else if (workload == "PolyaUrn") {
+                for (size_t s = 0; s < config.operations; ++s) {
+                    size_t i = ds.sample(gen);
+                    weights[i] += weight_dist(gen);
+                    ds.update(i, weights[i]);
+                }
+            } else if (workload == "SingleIncrease") {
+                for (size_t s = 0; s < config.operations; ++s) {
+                    weights[0] += weight_dist(gen);
+                    ds.update(0, weights[0]);
+                }
+            }
+        }
+        if constexpr (resizes) {
+            if (workload == "Insertion") {
+                for (size_t s = 0; s < config.operations; ++s) ds.push(weight_dist(gen));
+            } else if (workload == "Removal") {
+                for (size_t s = 0; s < config.operations; ++s) ds.pop();
+            }
+        }
+    }
+    return {repeat, config.operations, seconds};
+}
+
+template <typename Algo>
+Row run(const Config& config, const std::vector<double>& weights, size_t repeat) {
+    const std::string& workload = config.workload;
+    if (workload == "Construction") return run_construction<Algo>(config, weights, repeat);
+    if (workload == "Sampling") return run_sampling<Algo>(config, weights, repeat);
+    if (workload == "RandomIncrease" || workload == "PolyaUrn" || workload == "SingleIncrease"
+        || workload == "Insertion" || workload == "Removal")
+        return run_dynamic<Algo>(config, weights, repeat);
+    throw std::invalid_argument("unknown workload " + workload);
+}
+
+std::string cpu_model() {
+    std::ifstream cpuinfo("/proc/cpuinfo");
+    std::string line;
+    while (std::getline(cpuinfo, line)) {
+        if (line.rfind("model name", 0) == 0) {
+            size_t colon = line.find(':');
+            if (colon != std::string::npos) return line.substr(line.find_first_not_of(' ', colon + 1));
+        }
+    }
+    return "unknown";
+}
+
+std::vector<std::pair<std::string, std::string>> environment() {
+    char host[256] = {};
+    gethostname(host, sizeof(host) - 1);
+    struct utsname uts = {};
+    uname(&uts);
+    char timestamp[32];
+    std::time_t now = std::time(nullptr);
+    std::tm utc;
+    gmtime_r(&now, &utc);
+    std::strftime(timestamp, sizeof(timestamp), "%Y-%m-%dT%H:%M:%SZ", &utc);
+#ifdef __clang__
+    std::string compiler = std::string("clang ") + __clang_version__;
+#elif defined(__GNUC__)
+    std::string compiler = std::string("gcc ") + __VERSION__;
+#else
+    std::string compiler = "unknown";
+#endif
+#ifdef NDEBUG
+    std::string assertions = "off";
+#else
+    std::string assertions = "on";
+#endif
+    return {
+        {"timestamp", timestamp},
+        {"host", host},
+        {"kernel", std::string(uts.sysname) + " " + uts.release + " " + uts.machine},
+        {"cpu", cpu_model()},
+        {"hardware_threads", std::to_string(std::thread::hardware_concurrency())},
+        {"compiler", compiler},
+        {"assertions", assertions},
+    };
+}
+
+std::string json_string(const std::string& s) {
+    std::ostringstream out;
+    out << '"';
+    for (char c : s) {
+        if (c == '"' || c == '\\') out << '\\' << c;
+        else if (static_cast<unsigned char>(c) < 0x20)
+            out << "\\u00" << "0123456789abcdef"[c >> 4] << "0123456789abcdef"[c & 15];
+        else out << c;
+    }
+    out << '"';
+    return out.str();
+}
+
+void print_csv(const Config& config, const std::vector<Row>& rows) {
+    for (auto& [key, value] : environment()) std::cout << "# " << key << ": " << value << "\n";
+    std::cout << "structure,distribution,workload,n,threads,seed,repeat,operations,seconds,ns_per_op\n";
+    for (auto& row : rows) {
+        std::cout << config.structure << "," << config.distribution << "," << config.workload << "," << config.n << ","
+                  << config.threads << "," << config.seed << "," << row.repeat << "," << row.operations << ","
+                  << row.seconds << "," << (1e9 * row.seconds / row.operations) << "\n";
+    }
+    std::cout << std::flush;
+}
+
+void print_json(const Config& config, const std::vector<Row>& rows) {
+    std::cout << "{\n  \"environment\": {";
+    bool first = true;
+    for (auto& [key, value] : environment()) {
+        std::cout << (first ? "\n" : ",\n") << "    " << json_string(key) << ": " << json_string(value);
+        first = false;
+    }
+    std::cout << "\n  },\n  \"config\": {\"structure\": " << json_string(config.structure)
+              << ", \"distribution\": " << json_string(config.distribution)
+              << ", \"workload\": " << json_string(config.workload) << ", \"n\": " << config.n
+              << ", \"operations\": " << config.operations << ", \"repeats\": " << config.repeats
+              << ", \"threads\": " << config.threads << ", \"seed\": " << config.seed << "},\n  \"results\": [";
+    for (size_t r = 0; r < rows.size(); ++r) {
+        std::cout << (r ? ",\n" : "\n") << "    {\"repeat\": " << rows[r].repeat << ", \"operations\": "
+                  << rows[r].operations << ", \"seconds\": " << rows[r].seconds << ", \"ns_per_op\": "
+                  << (1e9 * rows[r].seconds / rows[r].operations) << "}";
+    }
+    std::cout << "\n  ]\n}" << std::endl;
+}
+
+int main(int argc, char** argv) {
+    try {
+        Config config = parse_arguments(argc, argv);
+        std::mt19937_64 weight_gen = make_generator(config.seed, 0);
+        std::vector<double> weights = generate_weights(config.distribution, config.n, weight_gen);
+        std::vector<Row> rows;
+        with_structure(config.structure, [&]<typename Algo>() {
+            for (size_t r = 0; r < config.repeats; ++r) rows.push_back(run<Algo>(config, weights, r));
+        });
+        if (config.format == "json") print_json(config, rows);
+        else print_csv(config, rows);
+    } catch (const std::exception& e) {
+        std::cerr << "BenchmarkDriver: " << e.what() << "\n" << usage;
+        return 1;
+    }
+    return 0;
+}
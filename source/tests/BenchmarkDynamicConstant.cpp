@@ -1,5 +1,6 @@
 #include <cstdint>
 #include <random>
+#include <sampling/ScopedCounters.hpp>
 #include <sampling/ScopedTimer.hpp>
 #include <sampling/DynamicProposalArray.hpp>
 #include <sampling/DynamicProposalArrayStar.hpp>
@@ -21,7 +22,9 @@ void benchmark_constant(size_t n, std::string name, std::mt19937_64& gen) {
         updates.emplace_back(i, weights[i]);
     }
     for (size_t t = 0; t < steps; ++t) {
-        tools::ScopedTimer timer(name + " Constant [n: " + std::to_string(t) + "]");
+        std::string prefix = name + " Constant [n: " + std::to_string(t) + "]";
+        tools::ScopedCounters counters(prefix);
+        tools::ScopedTimer timer(prefix);
         auto[i, w] = updates[t];
         pa.update(i, w);
     }
@@ -36,8 +39,8 @@ int main() {
     size_t repeats = 25;
 
     for (size_t r = 0; r < repeats; ++r) {
-        benchmark_constant<DynamicProposalArray>(n, "ProposalArray", gen);
-        benchmark_constant<DynamicProposalArrayStar>(n, "ProposalArrayStar", gen);
+        benchmark_constant<DynamicProposalArray<>>(n, "ProposalArray", gen);
+        benchmark_constant<DynamicProposalArrayStar<>>(n, "ProposalArrayStar", gen);
     }
 
     return 0;
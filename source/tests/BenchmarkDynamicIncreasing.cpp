@@ -1,5 +1,6 @@
 #include <cstdint>
 #include <random>
+#include <sampling/ScopedCounters.hpp>
 #include <sampling/ScopedTimer.hpp>
 #include <sampling/DynamicProposalArray.hpp>
 #include <sampling/DynamicProposalArrayStar.hpp>
@@ -18,7 +19,9 @@ void benchmark_increasing(size_t n, std::string name, std::mt19937_64& gen) {
     for (auto [i, dw] : updates) {
         Algo pa(weights);
         {
-            tools::ScopedTimer timer(name + " Increasing [n: " + std::to_string(dw) + "]");
+            std::string prefix = name + " Increasing [n: " + std::to_string(dw) + "]";
+            tools::ScopedCounters counters(prefix);
+            tools::ScopedTimer timer(prefix);
             pa.update(i, dw);
         }
     }
@@ -33,8 +36,8 @@ int main() {
     size_t repeats = 10;
 
     for (size_t r = 0; r < repeats; ++r) {
-        benchmark_increasing<DynamicProposalArray>(n, "ProposalArray", gen);
-        benchmark_increasing<DynamicProposalArrayStar>(n, "ProposalArrayStar", gen);
+        benchmark_increasing<DynamicProposalArray<>>(n, "ProposalArray", gen);
+        benchmark_increasing<DynamicProposalArrayStar<>>(n, "ProposalArrayStar", gen);
     }
 
     return 0;
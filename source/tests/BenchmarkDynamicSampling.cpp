@@ -1,13 +1,49 @@
 #include <cstdint>
+#include <iostream>
 #include <random>
+#include <type_traits>
+#include <sampling/ScopedCounters.hpp>
 #include <sampling/ScopedTimer.hpp>
 #include <sampling/DynamicProposalArray.hpp>
 #include <sampling/DynamicProposalArrayStar.hpp>
 #include <sampling/LogCascade.hpp>
 #include <sampling/BinaryTree.hpp>
+#include <sampling/AdaptiveSampler.hpp>
 
 using namespace sampling;
 
+// samples through the single-word fast path
+template <typename Algo>
+struct Fast : Algo {
+    using Algo::Algo;
+
+    template <typename Generator>
+    size_t sample(Generator&& gen) {
+        return Algo::sample_fast(gen);
+    }
+};
+
+// stores the weights in single precision
+template <typename Algo>
+struct Float : Algo {
+    Float(const std::vector<double>& weights) : Algo(std::vector<float>(weights.begin(), weights.end())) {}
+};
+
+// initial weights and increments; integer counts start at one, so that every index stays drawable
+template <typename Weight>
+auto weight_distribution(size_t n) {
+    if constexpr (std::is_integral_v<Weight>) return std::uniform_int_distribution<Weight>(1, n);
+    else return std::uniform_real_distribution<Weight>(0, n);
+}
+
+template <typename Algo>
+void report_memory(const Algo& pa, size_t n, std::string name) {
+    if constexpr (requires { pa.memory_usage(); }) {
+        std::cout << "Memory " << name << " [n: " << n << "] "
+                  << static_cast<double>(pa.memory_usage()) / n << " bytes/element" << std::endl;
+    }
+}
+
 template <typename Algo>
 void benchmark_random_increase(size_t n, size_t g, size_t samples, std::string name, std::mt19937_64& gen) {
     std::uniform_real_distribution<double> weight_dist(0, n);
@@ -17,41 +53,58 @@ void benchmark_random_increase(size_t n, size_t g, size_t samples, std::string n
     size_t substeps = steps / g;
     std::uniform_int_distribution<size_t> index_dist(0, n - 1);
     Algo pa(weights);
+    report_memory(pa, n, name);
     for (size_t t = 0; t < steps;) {
         {
-            tools::ScopedTimer timer(name + " RandomIncrease [n: " + std::to_string(t) + "]");
+            std::string prefix = name + " RandomIncrease [n: " + std::to_string(t) + "]";
+            tools::ScopedCounters counters(prefix, samples);
+            tools::ScopedTimer timer(prefix);
             for (size_t s = 0; s < samples; ++s) {
-                volatile size_t sample = pa.sample(gen);
+                [[maybe_unused]] volatile size_t sample = pa.sample(gen);
             }
         }
-        for (size_t s = 0; s < substeps; ++s) {
-            size_t i = index_dist(gen);
-            weights[i] += weight_dist(gen);
-            pa.update(i, weights[i]);
+        {
+            // the update phase is timed separately so that backends trading sampling for update time can be compared
+            std::string prefix = name + " RandomIncreaseUpdates [n: " + std::to_string(t) + "]";
+            tools::ScopedCounters counters(prefix, substeps);
+            tools::ScopedTimer timer(prefix);
+            for (size_t s = 0; s < substeps; ++s) {
+                size_t i = index_dist(gen);
+                weights[i] += weight_dist(gen);
+                pa.update(i, weights[i]);
+            }
         }
         t += substeps;
     }
 }
 
-template <typename Algo>
+template <typename Algo, typename Weight = double>
 void benchmark_polya_urn(size_t n, size_t g, size_t samples, std::string name, std::mt19937_64& gen) {
-    std::uniform_real_distribution<double> weight_dist(0, n);
-    std::vector<double> weights;
+    auto weight_dist = weight_distribution<Weight>(n);
+    std::vector<Weight> weights;
     for (size_t i = 0; i < n; ++i) weights.push_back(weight_dist(gen));
     size_t steps = 100 * n;
     size_t substeps = steps / g;
     Algo pa(weights);
+    report_memory(pa, n, name);
     for (size_t t = 0; t < steps;) {
         {
-            tools::ScopedTimer timer(name + " PolyaUrn [n: " + std::to_string(t) + "]");
+            std::string prefix = name + " PolyaUrn [n: " + std::to_string(t) + "]";
+            tools::ScopedCounters counters(prefix, samples);
+            tools::ScopedTimer timer(prefix);
             for (size_t s = 0; s < samples; ++s) {
-                volatile size_t sample = pa.sample(gen);
+                [[maybe_unused]] volatile size_t sample = pa.sample(gen);
             }
         }
-        for (size_t s = 0; s < substeps; ++s) {
-            size_t i = pa.sample(gen);
-            weights[i] += weight_dist(gen);
-            pa.update(i, weights[i]);
+        {
+            std::string prefix = name + " PolyaUrnUpdates [n: " + std::to_string(t) + "]";
+            tools::ScopedCounters counters(prefix, substeps);
+            tools::ScopedTimer timer(prefix);
+            for (size_t s = 0; s < substeps; ++s) {
+                size_t i = pa.sample(gen);
+                weights[i] += weight_dist(gen);
+                pa.update(i, weights[i]);
+            }
         }
         t += substeps;
     }
@@ -65,17 +118,25 @@ void benchmark_single_increase(size_t n, size_t g, size_t samples, std::string n
     size_t steps = 100 * n;
     size_t substeps = steps / g;
     Algo pa(weights);
+    report_memory(pa, n, name);
     for (size_t t = 0; t < steps;) {
         {
-            tools::ScopedTimer timer(name + " SingleIncrease [n: " + std::to_string(t) + "]");
+            std::string prefix = name + " SingleIncrease [n: " + std::to_string(t) + "]";
+            tools::ScopedCounters counters(prefix, samples);
+            tools::ScopedTimer timer(prefix);
             for (size_t s = 0; s < samples; ++s) {
-                volatile size_t sample = pa.sample(gen);
+                [[maybe_unused]] volatile size_t sample = pa.sample(gen);
             }
         }
-        for (size_t s = 0; s < substeps; ++s) {
-            size_t i = 0;
-            weights[i] += weight_dist(gen);
-            pa.update(i, weights[i]);
+        {
+            std::string prefix = name + " SingleIncreaseUpdates [n: " + std::to_string(t) + "]";
+            tools::ScopedCounters counters(prefix, substeps);
+            tools::ScopedTimer timer(prefix);
+            for (size_t s = 0; s < substeps; ++s) {
+                size_t i = 0;
+                weights[i] += weight_dist(gen);
+                pa.update(i, weights[i]);
+            }
         }
         t += substeps;
     }
@@ -92,18 +153,60 @@ int main() {
     size_t repeats = 10;
 
     for (size_t r = 0; r < repeats; ++r) {
-        benchmark_random_increase<DynamicProposalArray>(n, g, samples, "ProposalArray", gen);
-        benchmark_random_increase<DynamicProposalArrayStar>(n, g, samples, "ProposalArrayStar", gen);
+        benchmark_random_increase<DynamicProposalArray<>>(n, g, samples, "ProposalArray", gen);
+        benchmark_random_increase<DynamicProposalArrayStar<>>(n, g, samples, "ProposalArrayStar", gen);
+        benchmark_random_increase<DynamicProposalArray<CompactLayout>>(n, g, samples, "ProposalArrayCompact", gen);
+        benchmark_random_increase<DynamicProposalArrayStar<CompactLayout>>(n, g, samples, "ProposalArrayStarCompact", gen);
+        benchmark_random_increase<Fast<DynamicProposalArray<CompactLayout>>>(n, g, samples, "ProposalArrayCompactFast", gen);
+        benchmark_random_increase<Fast<DynamicProposalArrayStar<CompactLayout>>>(n, g, samples, "ProposalArrayStarCompactFast", gen);
         benchmark_random_increase<LogCascade<1>>(n, g, samples, "LogCascade", gen);
-        benchmark_random_increase<BinaryTree>(n, g, samples, "BinaryTree", gen);
-        benchmark_polya_urn<DynamicProposalArray>(n, g, samples, "ProposalArray", gen);
-        benchmark_polya_urn<DynamicProposalArrayStar>(n, g, samples, "ProposalArrayStar", gen);
+        benchmark_random_increase<BinaryTree<>>(n, g, samples, "BinaryTree", gen);
+        benchmark_random_increase<BinaryTree<4>>(n, g, samples, "BinaryTree4", gen);
+        benchmark_random_increase<BinaryTree<8>>(n, g, samples, "BinaryTree8", gen);
+        benchmark_random_increase<BinaryTree<16>>(n, g, samples, "BinaryTree16", gen);
+        benchmark_random_increase<AdaptiveSampler>(n, g, samples, "Adaptive", gen);
+        benchmark_random_increase<Float<DynamicProposalArray<WideLayout, float>>>(n, g, samples, "ProposalArrayFloat", gen);
+        benchmark_random_increase<Float<Fast<DynamicProposalArray<CompactLayout, float>>>>(n, g, samples, "ProposalArrayCompactFastFloat", gen);
+        benchmark_random_increase<Float<LogCascade<1, float>>>(n, g, samples, "LogCascadeFloat", gen);
+        benchmark_random_increase<Float<BinaryTree<2, float>>>(n, g, samples, "BinaryTreeFloat", gen);
+        benchmark_random_increase<Float<BinaryTree<8, float>>>(n, g, samples, "BinaryTree8Float", gen);
+        benchmark_polya_urn<DynamicProposalArray<>>(n, g, samples, "ProposalArray", gen);
+        benchmark_polya_urn<DynamicProposalArrayStar<>>(n, g, samples, "ProposalArrayStar", gen);
+        benchmark_polya_urn<DynamicProposalArray<CompactLayout>>(n, g, samples, "ProposalArrayCompact", gen);
+        benchmark_polya_urn<DynamicProposalArrayStar<CompactLayout>>(n, g, samples, "ProposalArrayStarCompact", gen);
+        benchmark_polya_urn<Fast<DynamicProposalArray<CompactLayout>>>(n, g, samples, "ProposalArrayCompactFast", gen);
+        benchmark_polya_urn<Fast<DynamicProposalArrayStar<CompactLayout>>>(n, g, samples, "ProposalArrayStarCompactFast", gen);
         benchmark_polya_urn<LogCascade<1>>(n, g, samples, "LogCascade", gen);
-        benchmark_polya_urn<BinaryTree>(n, g, samples, "BinaryTree", gen);
-        benchmark_single_increase<DynamicProposalArray>(n, g, samples, "ProposalArray", gen);
-        benchmark_single_increase<DynamicProposalArrayStar>(n, g, samples, "ProposalArrayStar", gen);
+        benchmark_polya_urn<BinaryTree<>>(n, g, samples, "BinaryTree", gen);
+        benchmark_polya_urn<BinaryTree<4>>(n, g, samples, "BinaryTree4", gen);
+        benchmark_polya_urn<BinaryTree<8>>(n, g, samples, "BinaryTree8", gen);
+        benchmark_polya_urn<BinaryTree<16>>(n, g, samples, "BinaryTree16", gen);
+        benchmark_polya_urn<AdaptiveSampler>(n, g, samples, "Adaptive", gen);
+        benchmark_polya_urn<Float<DynamicProposalArray<WideLayout, float>>>(n, g, samples, "ProposalArrayFloat", gen);
+        benchmark_polya_urn<Float<Fast<DynamicProposalArray<CompactLayout, float>>>>(n, g, samples, "ProposalArrayCompactFastFloat", gen);
+        benchmark_polya_urn<Float<LogCascade<1, float>>>(n, g, samples, "LogCascadeFloat", gen);
+        benchmark_polya_urn<Float<BinaryTree<2, float>>>(n, g, samples, "BinaryTreeFloat", gen);
+        benchmark_polya_urn<Float<BinaryTree<8, float>>>(n, g, samples, "BinaryTree8Float", gen);
+        benchmark_polya_urn<DynamicProposalArray<WideLayout, uint64_t>, uint64_t>(n, g, samples, "ProposalArrayInteger", gen);
+        benchmark_polya_urn<Fast<DynamicProposalArray<WideLayout, uint64_t>>, uint64_t>(n, g, samples, "ProposalArrayIntegerFast", gen);
+        benchmark_polya_urn<Fast<DynamicProposalArray<CompactLayout, uint64_t>>, uint64_t>(n, g, samples, "ProposalArrayIntegerCompactFast", gen);
+        benchmark_single_increase<DynamicProposalArray<>>(n, g, samples, "ProposalArray", gen);
+        benchmark_single_increase<DynamicProposalArrayStar<>>(n, g, samples, "ProposalArrayStar", gen);
+        benchmark_single_increase<DynamicProposalArray<CompactLayout>>(n, g, samples, "ProposalArrayCompact", gen);
+        benchmark_single_increase<DynamicProposalArrayStar<CompactLayout>>(n, g, samples, "ProposalArrayStarCompact", gen);
+        benchmark_single_increase<Fast<DynamicProposalArray<CompactLayout>>>(n, g, samples, "ProposalArrayCompactFast", gen);
+        benchmark_single_increase<Fast<DynamicProposalArrayStar<CompactLayout>>>(n, g, samples, "ProposalArrayStarCompactFast", gen);
         benchmark_single_increase<LogCascade<1>>(n, g, samples, "LogCascade", gen);
-        benchmark_single_increase<BinaryTree>(n, g, samples, "BinaryTree", gen);
+        benchmark_single_increase<BinaryTree<>>(n, g, samples, "BinaryTree", gen);
+        benchmark_single_increase<BinaryTree<4>>(n, g, samples, "BinaryTree4", gen);
+        benchmark_single_increase<BinaryTree<8>>(n, g, samples, "BinaryTree8", gen);
+        benchmark_single_increase<BinaryTree<16>>(n, g, samples, "BinaryTree16", gen);
+        benchmark_single_increase<AdaptiveSampler>(n, g, samples, "Adaptive", gen);
+        benchmark_single_increase<Float<DynamicProposalArray<WideLayout, float>>>(n, g, samples, "ProposalArrayFloat", gen);
+        benchmark_single_increase<Float<Fast<DynamicProposalArray<CompactLayout, float>>>>(n, g, samples, "ProposalArrayCompactFastFloat", gen);
+        benchmark_single_increase<Float<LogCascade<1, float>>>(n, g, samples, "LogCascadeFloat", gen);
+        benchmark_single_increase<Float<BinaryTree<2, float>>>(n, g, samples, "BinaryTreeFloat", gen);
+        benchmark_single_increase<Float<BinaryTree<8, float>>>(n, g, samples, "BinaryTree8Float", gen);
     }
 
     return 0;
@@ -2,6 +2,7 @@
 #include <random>
 #include <sampling/DynamicProposalArray.hpp>
 #include <sampling/DynamicProposalArrayStar.hpp>
+#include <sampling/ScopedCounters.hpp>
 #include <sampling/ScopedTimer.hpp>
 
 using namespace sampling;
@@ -17,7 +18,9 @@ void benchmark_update_types(size_t n, std::string name, std::mt19937_64& gen) {
             Algo pa(weights);
             weights[i] = 2.0;
             {
-                incpwl::ScopedTimer timer(name + " Types [n: 0]");
+                std::string prefix = name + " Types [n: 0]";
+                tools::ScopedCounters counters(prefix);
+                tools::ScopedTimer timer(prefix);
                 pa.update(i, weights[i]);
             }
         }
@@ -25,7 +28,9 @@ void benchmark_update_types(size_t n, std::string name, std::mt19937_64& gen) {
             Algo pa(weights);
             weights[i] = 1.0;
             {
-                incpwl::ScopedTimer timer(name + " Types [n: 3]");
+                std::string prefix = name + " Types [n: 3]";
+                tools::ScopedCounters counters(prefix);
+                tools::ScopedTimer timer(prefix);
                 pa.update(i, weights[i]);
             }
         }
@@ -39,8 +44,8 @@ int main() {
 
     size_t n = 10000000;
 
-    benchmark_update_types<DynamicProposalArray>(n, "ProposalArray", gen);
-    benchmark_update_types<DynamicProposalArrayStar>(n, "ProposalArrayStar", gen);
+    benchmark_update_types<DynamicProposalArray<>>(n, "ProposalArray", gen);
+    benchmark_update_types<DynamicProposalArrayStar<>>(n, "ProposalArrayStar", gen);
 
     return 0;
 }
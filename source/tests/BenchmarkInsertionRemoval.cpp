@@ -1,5 +1,6 @@
 #include <cstdint>
 #include <random>
+#include <sampling/ScopedCounters.hpp>
 #include <sampling/ScopedTimer.hpp>
 #include <sampling/DynamicProposalArray.hpp>
 #include <sampling/DynamicProposalArrayStar.hpp>
@@ -17,7 +18,9 @@ void benchmark_insertion(size_t nl, size_t nu, double f, size_t samples, std::st
     size_t n = nl;
     while (n < nu) {
         {
-            tools::ScopedTimer timer(name + " Insert [n: " + std::to_string(n) + "]");
+            std::string prefix = name + " Insert [n: " + std::to_string(n) + "]";
+            tools::ScopedCounters counters(prefix, samples);
+            tools::ScopedTimer timer(prefix);
             for (size_t s = 0; s < samples; ++s) {
                 volatile size_t sample = ds.sample(gen);
             }
@@ -40,7 +43,9 @@ void benchmark_removal(size_t nl, size_t nu, double f, size_t samples, std::stri
     size_t n = nu;
     while (n > nl / f) {
         {
-            tools::ScopedTimer timer(name + " Erase [n: " + std::to_string(n) + "]");
+            std::string prefix = name + " Erase [n: " + std::to_string(n) + "]";
+            tools::ScopedCounters counters(prefix, samples);
+            tools::ScopedTimer timer(prefix);
             for (size_t s = 0; s < samples; ++s) {
                 volatile size_t sample = ds.sample(gen);
             }
@@ -61,7 +66,9 @@ void benchmark_insertion_bt(size_t nl, size_t nu, double f, size_t samples, std:
     size_t n = nl;
     while (n < nu) {
         {
-            tools::ScopedTimer timer(name + " Insert [n: " + std::to_string(n) + "]");
+            std::string prefix = name + " Insert [n: " + std::to_string(n) + "]";
+            tools::ScopedCounters counters(prefix, samples);
+            tools::ScopedTimer timer(prefix);
             for (size_t s = 0; s < samples; ++s) {
                 volatile size_t sample = ds.sample(gen);
             }
@@ -83,7 +90,9 @@ void benchmark_removal_bt(size_t nl, size_t nu, double f, size_t samples, std::s
     size_t n = nu;
     while (n > nl / f) {
         {
-            tools::ScopedTimer timer(name + " Erase [n: " + std::to_string(n) + "]");
+            std::string prefix = name + " Erase [n: " + std::to_string(n) + "]";
+            tools::ScopedCounters counters(prefix, samples);
+            tools::ScopedTimer timer(prefix);
             for (size_t s = 0; s < samples; ++s) {
                 volatile size_t sample = ds.sample(gen);
             }
@@ -108,12 +117,12 @@ int main() {
     size_t repeats = 10;
 
     for (size_t r = 0; r < repeats; ++r) {
-        benchmark_insertion<DynamicProposalArray>(nl, nu, f, samples, "ProposalArray", gen);
-        benchmark_insertion<DynamicProposalArrayStar>(nl, nu, f, samples, "ProposalArrayStar", gen);
+        benchmark_insertion<DynamicProposalArray<>>(nl, nu, f, samples, "ProposalArray", gen);
+        benchmark_insertion<DynamicProposalArrayStar<>>(nl, nu, f, samples, "ProposalArrayStar", gen);
         benchmark_insertion<LogCascade<1>>(nl, nu, f, samples, "LogCascade", gen);
         benchmark_insertion_bt(nl, nu, f, samples, "BinaryTree", gen);
-        benchmark_removal<DynamicProposalArray>(nl, nu, f, samples, "ProposalArray", gen);
-        benchmark_removal<DynamicProposalArrayStar>(nl, nu, f, samples, "ProposalArrayStar", gen);
+        benchmark_removal<DynamicProposalArray<>>(nl, nu, f, samples, "ProposalArray", gen);
+        benchmark_removal<DynamicProposalArrayStar<>>(nl, nu, f, samples, "ProposalArrayStar", gen);
         benchmark_removal<LogCascade<1>>(nl, nu, f, samples, "LogCascade", gen);
         benchmark_removal_bt(nl, nu, f, samples, "BinaryTree", gen);
     }
@@ -1,5 +1,6 @@
 #include <cstdint>
 #include <random>
+#include <sampling/ScopedCounters.hpp>
 #include <sampling/ScopedTimer.hpp>
 #include <sampling/LogCascade.hpp>
 
@@ -20,13 +21,31 @@ template <typename Algo>
 void benchmark_sampling(const std::vector<double>& weights, size_t samples, std::string name, std::mt19937_64& gen) {
     Algo lc(weights);
     {
-        tools::ScopedTimer timer(name + " NoisyUniform" + " [n: " + std::to_string(weights.size()) + "]");
+        std::string prefix = name + " NoisyUniform" + " [n: " + std::to_string(weights.size()) + "]";
+        tools::ScopedCounters counters(prefix, samples);
+        tools::ScopedTimer timer(prefix);
         for (size_t s = 0; s < samples; ++s) {
             volatile size_t sample = lc.sample(gen);
         }
     }
 }
 
+// random reassignments, which move indices between partitions on every layer
+template <typename Algo>
+void benchmark_updates(const std::vector<double>& weights, size_t updates, std::string name, std::mt19937_64& gen) {
+    Algo lc(weights);
+    std::uniform_int_distribution<size_t> index_dist(0, weights.size() - 1);
+    std::uniform_real_distribution<double> weight_dist(0, weights.size());
+    {
+        std::string prefix = name + "Update NoisyUniform" + " [n: " + std::to_string(weights.size()) + "]";
+        tools::ScopedCounters counters(prefix, updates);
+        tools::ScopedTimer timer(prefix);
+        for (size_t u = 0; u < updates; ++u) {
+            lc.update(index_dist(gen), weight_dist(gen));
+        }
+    }
+}
+
 int main() {
     std::random_device rd;
     size_t seed = rd();
@@ -42,6 +61,10 @@ int main() {
             benchmark_sampling<LogCascade<2>>(weights, samples, "LogCascade2L", gen);
             benchmark_sampling<LogCascade<3>>(weights, samples, "LogCascade3L", gen);
             benchmark_sampling<LogCascade<4>>(weights, samples, "LogCascade4L", gen);
+            benchmark_updates<LogCascade<1>>(weights, samples, "LogCascade1L", gen);
+            benchmark_updates<LogCascade<2>>(weights, samples, "LogCascade2L", gen);
+            benchmark_updates<LogCascade<3>>(weights, samples, "LogCascade3L", gen);
+            benchmark_updates<LogCascade<4>>(weights, samples, "LogCascade4L", gen);
         }
     }
 
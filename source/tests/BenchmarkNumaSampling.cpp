@@ -0,0 +1,96 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <thread>
+#include <sampling/ScopedCounters.hpp>
+#include <sampling/Numa.hpp>
+#include <sampling/ProposalArray.hpp>
+#include <sampling/DynamicProposalArray.hpp>
+#include <sampling/ReplicatedSampler.hpp>
+
+using namespace sampling;
+
+// Aggregate sampling throughput over the thread count, with thread t pinned to node t % nodes. A single instance is
+// built by a thread pinned to node 0, so that threads on the other nodes read remote memory, against one replica per
+// node. On a machine with a single node both should be the same.
+
+template <typename Workload>
+void run_threads(size_t threads, double seconds, std::mt19937_64& gen, Workload&& workload, size_t& operations,
+                 tools::PerfCounters::Counts& counts) {
+    const NumaTopology& topology = NumaTopology::instance();
+    counts = {};
+    tools::ScopedCounters counters(counts);
+    std::atomic<bool> stop{false};
+    std::atomic<size_t> total{0};
+    std::vector<std::thread> workers;
+    for (size_t t = 0; t < threads; ++t) {
+        workers.emplace_back([&, t, seed = gen()] {
+            topology.pin_to_node(t % topology.nodes());
+            std::mt19937_64 thread_gen(seed);
+            size_t count = 0;
+            while (!stop.load(std::memory_order_relaxed)) {
+                for (size_t s = 0; s < 100; ++s) workload(thread_gen);
+                count += 100;
+            }
+            total += count;
+        });
+    }
+    std::this_thread::sleep_for(std::chrono::duration<double>(seconds));
+    stop = true;
+    for (auto& worker : workers) worker.join();
+    operations = total;
+}
+
+template <typename Algo>
+void benchmark_sampling(const std::vector<double>& weights, size_t threads, double seconds, std::string name,
+                        std::mt19937_64& gen) {
+    std::unique_ptr<Algo> ds;
+    std::thread([&] {
+        NumaTopology::instance().pin_to_node(0);
+        ds = std::make_unique<Algo>(weights);
+    }).join();
+    size_t operations;
+    tools::PerfCounters::Counts counts = {};
+    run_threads(threads, seconds, gen, [&](std::mt19937_64& thread_gen) {
+        [[maybe_unused]] volatile size_t sample = ds->sample(thread_gen);
+    }, operations, counts);
+    std::string prefix = name + " Sampling [n: " + std::to_string(threads) + "]";
+    std::cout << prefix << " Throughput: " << (operations / seconds) << " samples/s" << std::endl;
+    tools::ScopedCounters::report(prefix, counts, operations);
+}
+
+int main() {
+    std::random_device rd;
+    size_t seed = rd();
+    std::mt19937_64 gen(seed);
+
+    size_t n = 10000000;
+    double seconds = 5;
+    size_t repeats = 3;
+    size_t max_threads = std::max<unsigned>(std::thread::hardware_concurrency(), 1);
+    std::vector<size_t> thread_counts;
+    for (size_t threads = 1; threads < max_threads; threads *= 2) thread_counts.push_back(threads);
+    thread_counts.push_back(max_threads);
+    std::cout << "# nodes: " << NumaTopology::instance().nodes() << std::endl;
+
+    std::uniform_real_distribution<double> weight_dist(0, n);
+    std::vector<double> weights;
+    for (size_t i = 0; i < n; ++i) weights.push_back(weight_dist(gen));
+
+    for (size_t r = 0; r < repeats; ++r) {
+        for (size_t threads : thread_counts) {
+            benchmark_sampling<ProposalArray<>>(weights, threads, seconds, "ProposalArray", gen);
+            benchmark_sampling<ReplicatedSampler<ProposalArray<>>>(weights, threads, seconds,
+                                                                    "ReplicatedProposalArray", gen);
+            benchmark_sampling<DynamicProposalArray<>>(weights, threads, seconds, "DynamicProposalArray", gen);
+            benchmark_sampling<ReplicatedSampler<DynamicProposalArray<>>>(weights, threads, seconds,
+                                                                           "ReplicatedDynamicProposalArray", gen);
+        }
+    }
+
+    return 0;
+}
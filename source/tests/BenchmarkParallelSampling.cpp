@@ -0,0 +1,87 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <random>
+#include <thread>
+#include <sampling/ScopedCounters.hpp>
+#include <sampling/Sampler.hpp>
+#include <sampling/AliasTable.hpp>
+#include <sampling/ProposalArray.hpp>
+#include <sampling/BinaryTree.hpp>
+
+using namespace sampling;
+
+// Aggregate throughput of threads that each draw with their own generator from one shared, read-only instance, and
+// its speedup over a single thread. Sampling is const, so the threads share nothing but the cache lines they read.
+
+template <typename Workload>
+void run_threads(size_t threads, double seconds, std::mt19937_64& gen, Workload&& workload, size_t& operations,
+                 tools::PerfCounters::Counts& counts) {
+    counts = {};
+    tools::ScopedCounters counters(counts);
+    std::atomic<bool> stop{false};
+    std::atomic<size_t> total{0};
+    std::vector<std::thread> workers;
+    for (size_t t = 0; t < threads; ++t) {
+        workers.emplace_back([&, seed = gen()] {
+            std::mt19937_64 thread_gen(seed);
+            size_t count = 0;
+            while (!stop.load(std::memory_order_relaxed)) {
+                for (size_t s = 0; s < 100; ++s) workload(thread_gen);
+                count += 100;
+            }
+            total += count;
+        });
+    }
+    std::this_thread::sleep_for(std::chrono::duration<double>(seconds));
+    stop = true;
+    for (auto& worker : workers) worker.join();
+    operations = total;
+}
+
+template <SharedSampler Algo>
+void benchmark_sampling(size_t n, const std::vector<size_t>& thread_counts, double seconds, std::string name,
+                        std::mt19937_64& gen) {
+    std::uniform_real_distribution<double> weight_dist(0, n);
+    std::vector<double> weights;
+    for (size_t i = 0; i < n; ++i) weights.push_back(weight_dist(gen));
+    const Algo ds(weights);
+    double single = 0;
+    for (size_t threads : thread_counts) {
+        size_t operations;
+        tools::PerfCounters::Counts counts = {};
+        run_threads(threads, seconds, gen, [&](std::mt19937_64& thread_gen) {
+            [[maybe_unused]] volatile size_t sample = ds.sample(thread_gen);
+        }, operations, counts);
+        double throughput = operations / seconds;
+        if (threads == 1) single = throughput;
+        std::string prefix = name + " Sampling [n: " + std::to_string(n) + ", threads: " + std::to_string(threads)
+                             + "]";
+        std::cout << prefix << " Throughput: " << throughput << " samples/s Speedup: " << throughput / single
+                  << std::endl;
+        tools::ScopedCounters::report(prefix, counts, operations);
+    }
+}
+
+int main() {
+    std::random_device rd;
+    size_t seed = rd();
+    std::mt19937_64 gen(seed);
+
+    double seconds = 3;
+    size_t max_threads = std::max<unsigned>(std::thread::hardware_concurrency(), 1);
+    std::vector<size_t> thread_counts;
+    for (size_t threads = 1; threads < max_threads; threads *= 2) thread_counts.push_back(threads);
+    thread_counts.push_back(max_threads);
+
+    for (size_t n : {1000, 10000000}) {
+        benchmark_sampling<AliasTable<>>(n, thread_counts, seconds, "AliasTable", gen);
+        benchmark_sampling<ProposalArray<>>(n, thread_counts, seconds, "ProposalArray", gen);
+        benchmark_sampling<BinaryTree<>>(n, thread_counts, seconds, "BinaryTree", gen);
+        benchmark_sampling<BinaryTree<8>>(n, thread_counts, seconds, "BinaryTree8", gen);
+    }
+
+    return 0;
+}
@@ -1,6 +1,9 @@
 #include <cstdint>
+#include <iostream>
 #include <numbers>
 #include <random>
+#include <sampling/Allocator.hpp>
+#include <sampling/ScopedCounters.hpp>
 #include <sampling/ScopedTimer.hpp>
 #include <sampling/AliasTable.hpp>
 #include <sampling/ProposalArray.hpp>
@@ -49,44 +52,89 @@ std::vector<double> generate_noisy_delta_weights(size_t n, std::mt19937_64& gen)
     return weights;
 }
 
-void benchmark_at_sampling(const std::vector<double>& weights, size_t samples, std::mt19937_64& gen, std::string name) {
-    AliasTable at(weights);
+template <typename Layout, typename Allocator = std::allocator<std::byte>, typename Weight>
+void benchmark_at_sampling(const std::vector<Weight>& weights, size_t samples, std::mt19937_64& gen, std::string algo, std::string name) {
+    AliasTable<Layout, Weight, Allocator> at(weights);
+    std::cout << "Memory " << algo << " " << name << " [n: " << weights.size() << "] "
+              << static_cast<double>(at.memory_usage()) / weights.size() << " bytes/element" << std::endl;
     {
-        tools::ScopedTimer timer("AliasTable " + name + " [n: " + std::to_string(weights.size()) + "]");
+        std::string prefix = algo + " " + name + " [n: " + std::to_string(weights.size()) + "]";
+        tools::ScopedCounters counters(prefix, samples);
+        tools::ScopedTimer timer(prefix, samples);
         for (size_t s = 0; s < samples; ++s) {
             volatile size_t sample = at.sample(gen);
         }
     }
+    std::vector<size_t> out(samples);
+    {
+        std::string prefix = algo + "Bulk " + name + " [n: " + std::to_string(weights.size()) + "]";
+        tools::ScopedCounters counters(prefix, samples);
+        tools::ScopedTimer timer(prefix, samples);
+        at.sample_n(gen, out);
+    }
 }
 
-void benchmark_pa_sampling(const std::vector<double>& weights, size_t samples, std::mt19937_64& gen, std::string name) {
-    ProposalArray pa(weights);
+template <typename Layout, typename Allocator = std::allocator<std::byte>, typename Weight>
+void benchmark_pa_sampling(const std::vector<Weight>& weights, size_t samples, std::mt19937_64& gen, std::string algo, std::string name) {
+    ProposalArray<Layout, Weight, Allocator> pa(weights);
+    std::cout << "Memory " << algo << " " << name << " [n: " << weights.size() << "] "
+              << static_cast<double>(pa.memory_usage()) / weights.size() << " bytes/element" << std::endl;
     {
-        tools::ScopedTimer timer("ProposalArray " + name + " [n: " + std::to_string(weights.size()) + "]");
+        std::string prefix = algo + " " + name + " [n: " + std::to_string(weights.size()) + "]";
+        tools::ScopedCounters counters(prefix, samples);
+        tools::ScopedTimer timer(prefix, samples);
         for (size_t s = 0; s < samples; ++s) {
             volatile size_t sample = pa.sample(gen);
         }
     }
+    {
+        std::string prefix = algo + "Fast " + name + " [n: " + std::to_string(weights.size()) + "]";
+        tools::ScopedCounters counters(prefix, samples);
+        tools::ScopedTimer timer(prefix, samples);
+        for (size_t s = 0; s < samples; ++s) {
+            [[maybe_unused]] volatile size_t sample = pa.sample_fast(gen);
+        }
+    }
+    std::vector<size_t> out(samples);
+    {
+        std::string prefix = algo + "Bulk " + name + " [n: " + std::to_string(weights.size()) + "]";
+        tools::ScopedCounters counters(prefix, samples);
+        tools::ScopedTimer timer(prefix, samples);
+        pa.sample_n(gen, out);
+    }
 }
 
 void benchmark_dd_sampling(const std::vector<double>& weights, size_t samples, std::mt19937_64& gen, std::string name) {
     std::discrete_distribution<size_t> dd(weights.begin(), weights.end());
     {
-        tools::ScopedTimer timer("DiscreteDistribution " + name + " [n: " + std::to_string(weights.size()) + "]");
+        std::string prefix = "DiscreteDistribution " + name + " [n: " + std::to_string(weights.size()) + "]";
+        tools::ScopedCounters counters(prefix, samples);
+        tools::ScopedTimer timer(prefix, samples);
         for (size_t s = 0; s < samples; ++s) {
             volatile size_t sample = dd(gen);
         }
     }
 }
 
-void benchmark_bt_sampling(const std::vector<double>& weights, size_t samples, std::mt19937_64& gen, std::string name) {
-    BinaryTree bt(weights);
+template <size_t K, typename Allocator = std::allocator<std::byte>, typename Weight>
+void benchmark_bt_sampling(const std::vector<Weight>& weights, size_t samples, std::mt19937_64& gen, std::string algo,
+                           std::string name) {
+    BinaryTree<K, Weight, Allocator> bt(weights);
     {
-        tools::ScopedTimer timer("BinaryTree " + name + " [n: " + std::to_string(weights.size()) + "]");
+        std::string prefix = algo + " " + name + " [n: " + std::to_string(weights.size()) + "]";
+        tools::ScopedCounters counters(prefix, samples);
+        tools::ScopedTimer timer(prefix, samples);
         for (size_t s = 0; s < samples; ++s) {
             volatile size_t sample = bt.sample(gen);
         }
     }
+    std::vector<size_t> out(samples);
+    {
+        std::string prefix = algo + "Bulk " + name + " [n: " + std::to_string(weights.size()) + "]";
+        tools::ScopedCounters counters(prefix, samples);
+        tools::ScopedTimer timer(prefix, samples);
+        bt.sample_n(gen, out);
+    }
 }
 
 int main() {
@@ -106,9 +154,25 @@ int main() {
                     {generate_noisy_delta_weights(n, gen),   "NoisyDelta"}
             };
             for (auto[weights, name] : weights_names) {
-                benchmark_bt_sampling(weights, samples, gen, name);
-                benchmark_at_sampling(weights, samples, gen, name);
-                benchmark_pa_sampling(weights, samples, gen, name);
+                std::vector<float> float_weights(weights.begin(), weights.end());
+                benchmark_bt_sampling<2>(weights, samples, gen, "BinaryTree", name);
+                benchmark_bt_sampling<4>(weights, samples, gen, "BinaryTree4", name);
+                benchmark_bt_sampling<8>(weights, samples, gen, "BinaryTree8", name);
+                benchmark_bt_sampling<16>(weights, samples, gen, "BinaryTree16", name);
+                benchmark_bt_sampling<2>(float_weights, samples, gen, "BinaryTreeFloat", name);
+                benchmark_bt_sampling<8>(float_weights, samples, gen, "BinaryTree8Float", name);
+                benchmark_bt_sampling<8, HugePageAllocator<std::byte>>(weights, samples, gen, "BinaryTree8HugePages", name);
+                benchmark_at_sampling<WideLayout>(weights, samples, gen, "AliasTable", name);
+                benchmark_at_sampling<CompactLayout>(weights, samples, gen, "AliasTableCompact", name);
+                benchmark_pa_sampling<WideLayout>(weights, samples, gen, "ProposalArray", name);
+                benchmark_pa_sampling<CompactLayout>(weights, samples, gen, "ProposalArrayCompact", name);
+                benchmark_at_sampling<CompactLayout>(float_weights, samples, gen, "AliasTableCompactFloat", name);
+                benchmark_pa_sampling<CompactLayout>(float_weights, samples, gen, "ProposalArrayCompactFloat", name);
+                // the same arrays on 2 MiB pages, compare the dtlb-misses of the counter lines
+                benchmark_at_sampling<WideLayout, HugePageAllocator<std::byte>>(weights, samples, gen, "AliasTableHugePages", name);
+                benchmark_at_sampling<CompactLayout, HugePageAllocator<std::byte>>(weights, samples, gen, "AliasTableCompactHugePages", name);
+                benchmark_pa_sampling<WideLayout, HugePageAllocator<std::byte>>(weights, samples, gen, "ProposalArrayHugePages", name);
+                benchmark_pa_sampling<CompactLayout, HugePageAllocator<std::byte>>(weights, samples, gen, "ProposalArrayCompactHugePages", name);
             }
         }
     }
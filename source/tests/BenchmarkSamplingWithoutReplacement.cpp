@@ -0,0 +1,75 @@
+#include <cstdint>
+#include <random>
+#include <sampling/ScopedCounters.hpp>
+#include <sampling/ScopedTimer.hpp>
+#include <sampling/DynamicProposalArray.hpp>
+#include <sampling/DynamicProposalArrayStar.hpp>
+#include <sampling/BinaryTree.hpp>
+
+using namespace sampling;
+
+std::vector<double> generate_noisy_uniform_weights(size_t n, std::mt19937_64& gen) {
+    std::uniform_real_distribution<double> weight_dist(0, n);
+    std::vector<double> weights;
+    weights.reserve(n);
+    for (size_t i = 0; i < n; ++i) {
+        weights.push_back(weight_dist(gen));
+    }
+    return weights;
+}
+
+template <typename Algo>
+void benchmark_without_replacement(Algo& ds, size_t k, std::string name, std::mt19937_64& gen) {
+    std::vector<size_t> out;
+    std::string prefix = name + " NoisyUniform [k: " + std::to_string(k) + "]";
+    tools::ScopedCounters counters(prefix, k);
+    tools::ScopedTimer timer(prefix, k);
+    ds.sample_without_replacement(k, gen, out);
+}
+
+// the previous approach: sample, update to zero and restore all weights with update afterwards
+template <typename Algo>
+void benchmark_update_and_restore(Algo& ds, const std::vector<double>& weights, size_t k, std::string name,
+                                  std::mt19937_64& gen) {
+    std::vector<size_t> out;
+    std::string prefix = name + " NoisyUniform [k: " + std::to_string(k) + "]";
+    tools::ScopedCounters counters(prefix, k);
+    tools::ScopedTimer timer(prefix, k);
+    for (size_t s = 0; s < k; ++s) {
+        size_t i = ds.sample(gen);
+        out.push_back(i);
+        ds.update(i, 0.0);
+    }
+    for (size_t i : out) {
+        ds.update(i, weights[i]);
+    }
+}
+
+int main() {
+    std::random_device rd;
+    size_t seed = rd();
+    std::mt19937_64 gen(seed);
+
+    size_t n = 10000000;
+    std::vector<size_t> ks = {100, 1000, 10000, 100000, 1000000};
+    size_t repeats = 10;
+
+    auto weights = generate_noisy_uniform_weights(n, gen);
+    DynamicProposalArray<> dpa(weights);
+    DynamicProposalArrayStar<> dpa_star(weights);
+    BinaryTree<> bt(weights);
+    BinaryTree<8> bt8(weights);
+    for (size_t r = 0; r < repeats; ++r) {
+        for (size_t k : ks) {
+            benchmark_without_replacement(dpa, k, "ProposalArray", gen);
+            benchmark_update_and_restore(dpa, weights, k, "ProposalArrayUpdates", gen);
+            benchmark_without_replacement(dpa_star, k, "ProposalArrayStar", gen);
+            benchmark_update_and_restore(dpa_star, weights, k, "ProposalArrayStarUpdates", gen);
+            benchmark_without_replacement(bt, k, "BinaryTree", gen);
+            benchmark_update_and_restore(bt, weights, k, "BinaryTreeUpdates", gen);
+            benchmark_without_replacement(bt8, k, "BinaryTree8", gen);
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,102 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <mutex>
+#include <random>
+#include <thread>
+#include <sampling/ScopedCounters.hpp>
+#include <sampling/ShardedProposalArray.hpp>
+
+using namespace sampling;
+
+// every thread runs the workload on its own shard for the given duration, the counters cover all of them
+template <typename Workload>
+void run_threads(size_t threads, double seconds, std::mt19937_64& gen, Workload&& workload, size_t& operations,
+                 tools::PerfCounters::Counts& counts) {
+    counts = {};
+    tools::ScopedCounters counters(counts);
+    std::atomic<bool> stop{false};
+    std::atomic<size_t> total{0};
+    std::vector<std::thread> workers;
+    for (size_t t = 0; t < threads; ++t) {
+        workers.emplace_back([&, t, seed = gen()] {
+            std::mt19937_64 thread_gen(seed);
+            size_t count = 0;
+            while (!stop.load(std::memory_order_relaxed)) {
+                for (size_t s = 0; s < 100; ++s) workload(t, thread_gen);
+                count += 100;
+            }
+            total += count;
+        });
+    }
+    std::this_thread::sleep_for(std::chrono::duration<double>(seconds));
+    stop = true;
+    for (auto& worker : workers) worker.join();
+    operations = total;
+}
+
+void benchmark_sharded(size_t n, size_t threads, double seconds, std::mt19937_64& gen) {
+    std::uniform_real_distribution<double> weight_dist(0, n);
+    std::vector<double> weights;
+    for (size_t i = 0; i < n; ++i) weights.push_back(weight_dist(gen));
+    ShardedProposalArray<> ds(weights, threads);
+    size_t per_shard = n / threads;
+    size_t operations;
+    tools::PerfCounters::Counts counts = {};
+
+    run_threads(threads, seconds, gen, [&](size_t, std::mt19937_64& thread_gen) {
+        [[maybe_unused]] volatile size_t sample = ds.sample(thread_gen);
+    }, operations, counts);
+    std::cout << "ShardedProposalArray Sampling [n: " << threads << "] Throughput: " << (operations / seconds)
+              << " samples/s" << std::endl;
+    tools::ScopedCounters::report("ShardedProposalArray Sampling [n: " + std::to_string(threads) + "]", counts,
+                                  operations);
+
+    run_threads(threads, seconds, gen, [&](size_t t, std::mt19937_64& thread_gen) {
+        std::uniform_int_distribution<size_t> local_dist(0, per_shard - 1);
+        size_t i = local_dist(thread_gen) * threads + t;
+        weights[i] += weight_dist(thread_gen);
+        ds.update(i, weights[i]);
+    }, operations, counts);
+    std::cout << "ShardedProposalArray RandomIncrease [n: " << threads << "] Throughput: " << (operations / seconds)
+              << " updates/s" << std::endl;
+    tools::ScopedCounters::report("ShardedProposalArray RandomIncrease [n: " + std::to_string(threads) + "]", counts,
+                                  operations);
+
+    // sampled indices may lie in other shards, their weights are read back from the structure
+    std::vector<std::mutex> shard_mutexes(threads);
+    run_threads(threads, seconds, gen, [&](size_t, std::mt19937_64& thread_gen) {
+        size_t i = ds.sample(thread_gen);
+        std::lock_guard<std::mutex> lock(shard_mutexes[ds.shard_of(i)]);
+        weights[i] += weight_dist(thread_gen);
+        ds.update(i, weights[i]);
+    }, operations, counts);
+    std::cout << "ShardedProposalArray PolyaUrn [n: " << threads << "] Throughput: " << (operations / seconds)
+              << " samples+updates/s" << std::endl;
+    tools::ScopedCounters::report("ShardedProposalArray PolyaUrn [n: " + std::to_string(threads) + "]", counts,
+                                  operations);
+}
+
+int main() {
+    std::random_device rd;
+    size_t seed = rd();
+    std::mt19937_64 gen(seed);
+
+    size_t n = 10000000;
+    double seconds = 5;
+    size_t repeats = 3;
+    size_t max_threads = std::max<unsigned>(std::thread::hardware_concurrency(), 1);
+    std::vector<size_t> thread_counts;
+    for (size_t threads = 1; threads < max_threads; threads *= 2) thread_counts.push_back(threads);
+    thread_counts.push_back(max_threads);
+
+    for (size_t r = 0; r < repeats; ++r) {
+        for (size_t threads : thread_counts) {
+            benchmark_sharded(n, threads, seconds, gen);
+        }
+    }
+
+    return 0;
+}
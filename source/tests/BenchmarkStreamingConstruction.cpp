@@ -0,0 +1,64 @@
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <sampling/ScopedCounters.hpp>
+#include <sampling/ScopedTimer.hpp>
+#include <sampling/ProposalArray.hpp>
+#include <sampling/ProposalArrayBuilder.hpp>
+
+using namespace sampling;
+
+// writes n noisy uniform weights in chunks, so that n is not limited by memory
+void generate_noisy_uniform_weight_file(const std::string& path, size_t n, std::mt19937_64& gen) {
+    std::uniform_real_distribution<double> weight_dist(1, n);
+    std::ofstream out(path, std::ios::binary);
+    std::vector<double> chunk;
+    for (size_t i = 0; i < n; i += chunk.size()) {
+        chunk.clear();
+        for (size_t k = 0; k < std::min<size_t>(1 << 20, n - i); ++k) chunk.push_back(weight_dist(gen));
+        out.write(reinterpret_cast<const char*>(chunk.data()), chunk.size() * sizeof(double));
+    }
+}
+
+void benchmark_pa_streaming_construction(const std::string& weights_path, const std::string& output_path, size_t n,
+                                         std::string name) {
+    std::string prefix = "ProposalArrayStreaming " + name + " [n: " + std::to_string(n) + "]";
+    tools::ScopedCounters counters(prefix, n);
+    tools::ScopedTimer timer(prefix);
+    build_proposal_array(weights_path, output_path);
+}
+
+// the in-memory baseline reads the whole file and saves the built structure
+void benchmark_pa_in_memory_construction(const std::string& weights_path, const std::string& output_path, size_t n,
+                                         std::string name) {
+    std::string prefix = "ProposalArray " + name + " [n: " + std::to_string(n) + "]";
+    tools::ScopedCounters counters(prefix, n);
+    tools::ScopedTimer timer(prefix);
+    std::vector<double> weights(n);
+    std::ifstream(weights_path, std::ios::binary).read(reinterpret_cast<char*>(weights.data()), n * sizeof(double));
+    ProposalArray(weights).save(output_path);
+}
+
+int main() {
+    std::random_device rd;
+    size_t seed = rd();
+    std::mt19937_64 gen(seed);
+
+    std::vector<size_t> ns = {1000000, 10000000, 100000000};
+    size_t repeats = 3;
+    auto directory = std::filesystem::temp_directory_path();
+    std::string weights_path = directory / "sampling_benchmark_weights.bin";
+    std::string output_path = directory / "sampling_benchmark.bin";
+
+    for (auto n : ns) {
+        for (size_t r = 0; r < repeats; ++r) {
+            generate_noisy_uniform_weight_file(weights_path, n, gen);
+            benchmark_pa_streaming_construction(weights_path, output_path, n, "NoisyUniform");
+            benchmark_pa_in_memory_construction(weights_path, output_path, n, "NoisyUniform");
+        }
+    }
+    std::filesystem::remove(weights_path);
+    std::filesystem::remove(output_path);
+
+    return 0;
+}
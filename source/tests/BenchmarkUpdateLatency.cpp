@@ -0,0 +1,118 @@
+#include <cstdint>
+#include <random>
+#include <sampling/LatencyHistogram.hpp>
+#include <sampling/ScopedCounters.hpp>
+#include <sampling/DynamicProposalArray.hpp>
+#include <sampling/DynamicProposalArrayStar.hpp>
+#include <sampling/LogCascade.hpp>
+#include <sampling/BinaryTree.hpp>
+
+using namespace sampling;
+
+// Records the latency of every single update, push and pop instead of the mean over a batch, so that the tail shows
+// whether rebuilds are amortized (rare, long pauses) or deamortized (bounded work per operation).
+
+template <typename Algo>
+void benchmark_random_increase(size_t n, std::string name, std::mt19937_64& gen) {
+    std::uniform_real_distribution<double> weight_dist(0, n);
+    std::vector<double> weights;
+    for (size_t i = 0; i < n; ++i) weights.push_back(weight_dist(gen));
+    std::uniform_int_distribution<size_t> index_dist(0, n - 1);
+    Algo pa(weights);
+    std::string prefix = name + " RandomIncrease [n: " + std::to_string(n) + "]";
+    tools::LatencyHistogram histogram;
+    tools::ScopedCounters counters(prefix, 10 * n);
+    for (size_t t = 0; t < 10 * n; ++t) {
+        size_t i = index_dist(gen);
+        weights[i] += weight_dist(gen);
+        histogram.time([&] { pa.update(i, weights[i]); });
+    }
+    histogram.report(prefix);
+}
+
+template <typename Algo>
+void benchmark_polya_urn(size_t n, std::string name, std::mt19937_64& gen) {
+    std::uniform_real_distribution<double> weight_dist(0, n);
+    std::vector<double> weights;
+    for (size_t i = 0; i < n; ++i) weights.push_back(weight_dist(gen));
+    Algo pa(weights);
+    std::string prefix = name + " PolyaUrn [n: " + std::to_string(n) + "]";
+    tools::LatencyHistogram histogram;
+    tools::ScopedCounters counters(prefix, 10 * n);
+    for (size_t t = 0; t < 10 * n; ++t) {
+        size_t i = pa.sample(gen);
+        weights[i] += weight_dist(gen);
+        histogram.time([&] { pa.update(i, weights[i]); });
+    }
+    histogram.report(prefix);
+}
+
+template <typename Algo>
+void benchmark_single_increase(size_t n, std::string name, std::mt19937_64& gen) {
+    std::uniform_real_distribution<double> weight_dist(0, n);
+    std::vector<double> weights;
+    for (size_t i = 0; i < n; ++i) weights.push_back(weight_dist(gen));
+    Algo pa(weights);
+    std::string prefix = name + " SingleIncrease [n: " + std::to_string(n) + "]";
+    tools::LatencyHistogram histogram;
+    tools::ScopedCounters counters(prefix, 10 * n);
+    for (size_t t = 0; t < 10 * n; ++t) {
+        weights[0] += weight_dist(gen);
+        histogram.time([&] { pa.update(0, weights[0]); });
+    }
+    histogram.report(prefix);
+}
+
+// grows the structure from n to f * n elements and shrinks it back
+template <typename Algo>
+void benchmark_insertion_removal(size_t n, size_t f, std::string name, std::mt19937_64& gen) {
+    std::uniform_real_distribution<double> weight_dist(0, n);
+    std::vector<double> weights;
+    for (size_t i = 0; i < n; ++i) weights.push_back(weight_dist(gen));
+    Algo ds(weights);
+    tools::LatencyHistogram histogram;
+    {
+        tools::ScopedCounters counters(name + " Insert [n: " + std::to_string(n) + "]", (f - 1) * n);
+        for (size_t i = n; i < f * n; ++i) {
+            double w = weight_dist(gen);
+            histogram.time([&] { ds.push(w); });
+        }
+    }
+    histogram.report(name + " Insert [n: " + std::to_string(n) + "]");
+    histogram.reset();
+    {
+        tools::ScopedCounters counters(name + " Erase [n: " + std::to_string(n) + "]", (f - 1) * n);
+        for (size_t i = f * n; i > n; --i) {
+            histogram.time([&] { ds.pop(); });
+        }
+    }
+    histogram.report(name + " Erase [n: " + std::to_string(n) + "]");
+}
+
+int main() {
+    std::random_device rd;
+    size_t seed = rd();
+    std::mt19937_64 gen(seed);
+
+    size_t n = 1000000;
+    size_t f = 4;
+
+    benchmark_random_increase<DynamicProposalArray<>>(n, "ProposalArray", gen);
+    benchmark_random_increase<DynamicProposalArrayStar<>>(n, "ProposalArrayStar", gen);
+    benchmark_random_increase<LogCascade<1>>(n, "LogCascade", gen);
+    benchmark_random_increase<BinaryTree<>>(n, "BinaryTree", gen);
+    benchmark_polya_urn<DynamicProposalArray<>>(n, "ProposalArray", gen);
+    benchmark_polya_urn<DynamicProposalArrayStar<>>(n, "ProposalArrayStar", gen);
+    benchmark_polya_urn<LogCascade<1>>(n, "LogCascade", gen);
+    benchmark_polya_urn<BinaryTree<>>(n, "BinaryTree", gen);
+    benchmark_single_increase<DynamicProposalArray<>>(n, "ProposalArray", gen);
+    benchmark_single_increase<DynamicProposalArrayStar<>>(n, "ProposalArrayStar", gen);
+    benchmark_single_increase<LogCascade<1>>(n, "LogCascade", gen);
+    benchmark_single_increase<BinaryTree<>>(n, "BinaryTree", gen);
+    benchmark_insertion_removal<DynamicProposalArray<>>(n, f, "ProposalArray", gen);
+    benchmark_insertion_removal<DynamicProposalArrayStar<>>(n, f, "ProposalArrayStar", gen);
+    benchmark_insertion_removal<LogCascade<1>>(n, f, "LogCascade", gen);
+    benchmark_insertion_removal<BinaryTree<>>(n, f, "BinaryTree", gen);
+
+    return 0;
+}
@@ -1,14 +1,101 @@
+#include <cassert>
+#include <cmath>
+#include <filesystem>
+#include <fstream>
 #include <iostream>
+#include <memory_resource>
 #include <random>
+#include <sampling/Allocator.hpp>
 #include <sampling/AliasTable.hpp>
 #include <sampling/ProposalArray.hpp>
+#include <sampling/MappedAliasTable.hpp>
+#include <sampling/MappedProposalArray.hpp>
+#include <sampling/ProposalArrayBuilder.hpp>
 #include <sampling/DynamicProposalArray.hpp>
 #include <sampling/DynamicProposalArrayStar.hpp>
 #include <sampling/BinaryTree.hpp>
+#include <sampling/ConcurrentSampler.hpp>
+#include <sampling/ShardedProposalArray.hpp>
+#include <sampling/ReplicatedSampler.hpp>
 #include <sampling/LogCascade.hpp>
+#include <sampling/AdaptiveSampler.hpp>
 
 using namespace sampling;
 
+// constructs with several threads
+template <typename Algo>
+struct Parallel : Algo {
+    Parallel(const std::vector<double>& weights) : Algo(weights, 3) {}
+};
+
+// stores the weights in single precision
+template <typename Algo>
+struct Float : Algo {
+    Float(const std::vector<double>& weights) : Algo(std::vector<float>(weights.begin(), weights.end())) {}
+};
+
+// stores the weights as integer counts in units of 0.01
+struct Integer : DynamicProposalArray<WideLayout, uint64_t> {
+    Integer(const std::vector<double>& weights) : DynamicProposalArray(counts(weights)) {}
+
+    void update(size_t i, double w) {
+        DynamicProposalArray::update(i, std::llround(100 * w));
+    }
+
+    static std::vector<uint64_t> counts(const std::vector<double>& weights) {
+        std::vector<uint64_t> counts;
+        for (double w : weights) counts.push_back(std::llround(100 * w));
+        return counts;
+    }
+};
+
+// splits into two shards
+struct Sharded : ShardedProposalArray<> {
+    Sharded(const std::vector<double>& weights) : ShardedProposalArray<>(weights, 2) {}
+};
+
+// saves the built structure to a temporary file and samples from its mapping
+template <typename Built, typename View>
+struct Mapped : View {
+    Mapped(const std::vector<double>& weights) : View(save(weights)) {}
+
+    static std::string save(const std::vector<double>& weights) {
+        std::string path = std::filesystem::temp_directory_path() / "sampling_test.bin";
+        Built(weights).save(path);
+        return path;
+    }
+};
+
+// builds the file from a weight file in chunks of one weight and samples from its mapping
+struct Streamed : MappedProposalArray<> {
+    Streamed(const std::vector<double>& weights) : MappedProposalArray<>(build(weights)) {}
+
+    static std::string build(const std::vector<double>& weights) {
+        auto directory = std::filesystem::temp_directory_path();
+        std::ofstream(directory / "sampling_weights.bin", std::ios::binary)
+                .write(reinterpret_cast<const char*>(weights.data()), weights.size() * sizeof(double));
+        build_proposal_array(directory / "sampling_weights.bin", directory / "sampling_test.bin", 1);
+        return directory / "sampling_test.bin";
+    }
+};
+
+// starts on the given backend, which it leaves once the sampling-only phase shows another one to be cheaper
+template <AdaptiveSampler::Backend B>
+struct Adaptive : AdaptiveSampler {
+    Adaptive(const std::vector<double>& weights) : AdaptiveSampler(weights, B) {}
+};
+
+// samples through the single-word fast path
+template <typename Algo>
+struct Fast : Algo {
+    using Algo::Algo;
+
+    template <typename Generator>
+    size_t sample(Generator&& gen) {
+        return Algo::sample_fast(gen);
+    }
+};
+
 template <typename Algo, typename Generator>
 void test_ds(const std::vector<double>& weights, size_t samples, const char* name, Generator&& gen) {
     Algo ds(weights);
@@ -25,6 +112,23 @@ void test_ds(const std::vector<double>& weights, size_t samples, const char* nam
     std::cout << "]" << std::endl;
 }
 
+template <typename Algo, typename Generator>
+void test_ds_bulk(const std::vector<double>& weights, size_t samples, const char* name, Generator&& gen) {
+    Algo ds(weights);
+    std::vector<size_t> counts(weights.size(), 0);
+    std::vector<size_t> out(samples);
+    ds.sample_n(gen, out);
+    for (size_t i : out) {
+        counts[i]++;
+    }
+    std::cout << name << " [";
+    for (size_t i = 0; i < weights.size(); ++i) {
+        std::cout << counts[i];
+        if (i < weights.size() - 1) std::cout << " ";
+    }
+    std::cout << "]" << std::endl;
+}
+
 template <typename Algo, typename Generator>
 void test_dynamic_ds(const std::vector<double>& weights, const std::vector<double>& mod_weights,
                      size_t samples, size_t mod_samples, const char* name, Generator&& gen) {
@@ -55,6 +159,85 @@ void test_dynamic_ds(const std::vector<double>& weights, const std::vector<doubl
     std::cout << "]" << std::endl;
 }
 
+template <typename Algo, typename Generator>
+void test_dynamic_ds_batched(const std::vector<double>& weights, const std::vector<double>& mod_weights,
+                     size_t samples, size_t mod_samples, const char* name, Generator&& gen) {
+    Algo ds(weights);
+    std::vector<size_t> counts(weights.size(), 0);
+    std::vector<size_t> mod_counts(mod_weights.size(), 0);
+    for (size_t s = 0; s < samples; ++s) {
+        size_t i = ds.sample(gen);
+        counts[i]++;
+    }
+    std::vector<std::pair<size_t, double>> updates;
+    for (size_t i = 0; i < weights.size(); ++i) {
+        updates.emplace_back(i, mod_weights[i]);
+    }
+    ds.update_many(updates);
+    for (size_t s = 0; s < mod_samples; ++s) {
+        size_t i = ds.sample(gen);
+        mod_counts[i]++;
+    }
+    std::cout << name << " [";
+    for (size_t i = 0; i < weights.size(); ++i) {
+        std::cout << counts[i];
+        if (i < weights.size() - 1) std::cout << " ";
+    }
+    std::cout << " | ";
+    for (size_t i = 0; i < weights.size(); ++i) {
+        std::cout << mod_counts[i];
+        if (i < weights.size() - 1) std::cout << " ";
+    }
+    std::cout << "]" << std::endl;
+}
+
+// pushes zero weights, scales all weights up so that the rebuild moves on, pops back to the original size and samples
+template <typename Algo, typename Generator>
+void test_push_pop(const std::vector<double>& weights, size_t samples, const char* name, Generator&& gen) {
+    Algo ds(weights);
+    for (size_t k = 0; k < weights.size(); ++k) ds.push(0.0);
+    for (size_t i = 0; i < weights.size(); ++i) ds.update(i, 1.6 * weights[i]);
+    for (size_t k = 0; k < weights.size(); ++k) ds.pop();
+    std::vector<size_t> counts(weights.size(), 0);
+    for (size_t s = 0; s < samples; ++s) {
+        size_t i = ds.sample(gen);
+        counts[i]++;
+    }
+    std::cout << name << " [";
+    for (size_t i = 0; i < weights.size(); ++i) {
+        std::cout << counts[i];
+        if (i < weights.size() - 1) std::cout << " ";
+    }
+    std::cout << "]" << std::endl;
+}
+
+// counts over repeated draws of two distinct indices
+template <typename Algo, typename Generator>
+void test_without_replacement(const std::vector<double>& weights, size_t samples, const char* name, Generator&& gen) {
+    Algo ds(weights);
+    std::vector<size_t> counts(weights.size(), 0);
+    std::vector<size_t> out;
+    for (size_t s = 0; s < samples / 2; ++s) {
+        ds.sample_without_replacement(2, gen, out);
+        assert(out.size() == 2 && out[0] != out[1]);
+        counts[out[0]]++;
+        counts[out[1]]++;
+    }
+    std::cout << name << " [";
+    for (size_t i = 0; i < weights.size(); ++i) {
+        std::cout << counts[i];
+        if (i < weights.size() - 1) std::cout << " ";
+    }
+    std::cout << "]" << std::endl;
+}
+
+// sampling leaves the structures unchanged, so threads may share them
+static_assert(SharedSampler<AliasTable<>> && SharedSampler<ProposalArray<>> && SharedSampler<MappedAliasTable<>>
+              && SharedSampler<MappedProposalArray<>> && SharedSampler<DynamicProposalArray<>>
+              && SharedSampler<DynamicProposalArrayStar<>> && SharedSampler<BinaryTree<>> && SharedSampler<LogCascade<1>>
+              && SharedSampler<ConcurrentSampler<>> && SharedSampler<ShardedProposalArray<>>
+              && SharedSampler<ReplicatedSampler<>>);
+
 int main() {
     std::random_device rd;
     size_t seed = rd();
@@ -64,17 +247,75 @@ int main() {
     const double W = 8.6;
     const size_t samples = 1000000 * W;
 
-    test_ds<AliasTable>(weights, samples, "Alias Table", gen);
-    test_ds<ProposalArray>(weights, samples, "Proposal Array", gen);
+    test_ds<AliasTable<>>(weights, samples, "Alias Table", gen);
+    test_ds<ProposalArray<>>(weights, samples, "Proposal Array", gen);
+    test_ds_bulk<AliasTable<>>(weights, samples, "Alias Table Bulk", gen);
+    test_ds_bulk<ProposalArray<>>(weights, samples, "Proposal Array Bulk", gen);
+    test_ds_bulk<BinaryTree<>>(weights, samples, "Binary Tree Bulk", gen);
+    test_ds_bulk<BinaryTree<8>>(weights, samples, "8-ary Tree Bulk", gen);
+    test_ds<AliasTable<CompactLayout>>(weights, samples, "Alias Table Compact", gen);
+    test_ds<ProposalArray<CompactLayout>>(weights, samples, "Proposal Array Compact", gen);
+    test_ds<Fast<ProposalArray<>>>(weights, samples, "Proposal Array Fast", gen);
+    test_ds<Fast<ProposalArray<CompactLayout>>>(weights, samples, "Proposal Array Compact Fast", gen);
+    test_ds<Parallel<AliasTable<>>>(weights, samples, "Alias Table Parallel", gen);
+    test_ds<Parallel<ProposalArray<>>>(weights, samples, "Proposal Array Parallel", gen);
+    test_ds<Mapped<AliasTable<>, MappedAliasTable<>>>(weights, samples, "Alias Table Mapped", gen);
+    test_ds<Mapped<ProposalArray<>, MappedProposalArray<>>>(weights, samples, "Proposal Array Mapped", gen);
+    test_ds<Fast<Mapped<ProposalArray<CompactLayout>, MappedProposalArray<CompactLayout>>>>(
+            weights, samples, "Proposal Array Compact Mapped Fast", gen);
+    test_ds<Streamed>(weights, samples, "Proposal Array Streamed", gen);
+
+    // the arrays of the files end off the 64-byte alignment
+    const std::vector<double> odd_weights = {5.0, 1.5, 0.1, 2.0, 1.4};
+    const double odd_W = 10.0;
+    const size_t odd_samples = 1000000 * odd_W;
+
+    test_ds<Mapped<AliasTable<>, MappedAliasTable<>>>(odd_weights, odd_samples, "Alias Table Mapped Odd", gen);
+    test_ds<Mapped<AliasTable<CompactLayout>, MappedAliasTable<CompactLayout>>>(
+            odd_weights, odd_samples, "Alias Table Compact Mapped Odd", gen);
+    test_ds<Mapped<ProposalArray<CompactLayout>, MappedProposalArray<CompactLayout>>>(
+            odd_weights, odd_samples, "Proposal Array Compact Mapped Odd", gen);
+
+    test_ds<Float<AliasTable<CompactLayout, float>>>(weights, samples, "Alias Table Compact Float", gen);
+    test_ds<ReplicatedSampler<>>(weights, samples, "Proposal Array Replicated", gen);
 
     const std::vector<double> mod_weights = {2.5, 10.0, 1.0, 0.01};
     const double mod_W = 13.51;
     const size_t mod_samples = 1000000 * mod_W;
 
-    test_dynamic_ds<DynamicProposalArray>(weights, mod_weights, samples, mod_samples, "Dynamic PA", gen);
-    test_dynamic_ds<DynamicProposalArrayStar>(weights, mod_weights, samples, mod_samples, "Dynamic PA*", gen);
-    test_dynamic_ds<BinaryTree>(weights, mod_weights, samples, mod_samples, "Binary Tree", gen);
+    test_dynamic_ds<DynamicProposalArray<>>(weights, mod_weights, samples, mod_samples, "Dynamic PA", gen);
+    test_dynamic_ds<DynamicProposalArrayStar<>>(weights, mod_weights, samples, mod_samples, "Dynamic PA*", gen);
+    test_dynamic_ds<DynamicProposalArray<CompactLayout>>(weights, mod_weights, samples, mod_samples, "Dynamic PA Compact", gen);
+    test_dynamic_ds<DynamicProposalArrayStar<CompactLayout>>(weights, mod_weights, samples, mod_samples, "Dynamic PA* Compact", gen);
+    test_dynamic_ds_batched<DynamicProposalArray<>>(weights, mod_weights, samples, mod_samples, "Dynamic PA Batched", gen);
+    test_dynamic_ds<ConcurrentSampler<>>(weights, mod_weights, samples, mod_samples, "Concurrent PA", gen);
+    test_dynamic_ds<Sharded>(weights, mod_weights, samples, mod_samples, "Sharded PA", gen);
+    test_dynamic_ds<ReplicatedSampler<DynamicProposalArray<>>>(weights, mod_weights, samples, mod_samples, "Replicated PA", gen);
+    test_dynamic_ds<Parallel<DynamicProposalArray<>>>(weights, mod_weights, samples, mod_samples, "Dynamic PA Parallel", gen);
+    test_dynamic_ds<Fast<DynamicProposalArray<CompactLayout>>>(weights, mod_weights, samples, mod_samples, "Dynamic PA Compact Fast", gen);
+    test_dynamic_ds<Fast<DynamicProposalArrayStar<CompactLayout>>>(weights, mod_weights, samples, mod_samples, "Dynamic PA* Compact Fast", gen);
+    test_dynamic_ds<BinaryTree<>>(weights, mod_weights, samples, mod_samples, "Binary Tree", gen);
+    test_dynamic_ds<BinaryTree<4>>(weights, mod_weights, samples, mod_samples, "4-ary Tree", gen);
+    test_dynamic_ds<BinaryTree<16>>(weights, mod_weights, samples, mod_samples, "16-ary Tree", gen);
     test_dynamic_ds<LogCascade<3>>(weights, mod_weights, samples, mod_samples, "Log Cascade Iterated", gen);
+    test_dynamic_ds<Float<DynamicProposalArray<CompactLayout, float>>>(weights, mod_weights, samples, mod_samples, "Dynamic PA Compact Float", gen);
+    test_dynamic_ds<Float<DynamicProposalArrayStar<WideLayout, float>>>(weights, mod_weights, samples, mod_samples, "Dynamic PA* Float", gen);
+    test_dynamic_ds<Float<BinaryTree<8, float>>>(weights, mod_weights, samples, mod_samples, "8-ary Tree Float", gen);
+    test_dynamic_ds<Float<LogCascade<1, float>>>(weights, mod_weights, samples, mod_samples, "Log Cascade Float", gen);
+    test_dynamic_ds<Float<ConcurrentSampler<DynamicProposalArray<WideLayout, float>>>>(weights, mod_weights, samples, mod_samples, "Concurrent PA Float", gen);
+    test_dynamic_ds<Integer>(weights, mod_weights, samples, mod_samples, "Dynamic PA Integer", gen);
+    test_dynamic_ds<Fast<Integer>>(weights, mod_weights, samples, mod_samples, "Dynamic PA Integer Fast", gen);
+    test_dynamic_ds<DynamicProposalArray<WideLayout, double, HugePageAllocator<std::byte>>>(weights, mod_weights, samples, mod_samples, "Dynamic PA Huge Pages", gen);
+    test_dynamic_ds<LogCascade<2, double, std::pmr::polymorphic_allocator<std::byte>>>(weights, mod_weights, samples, mod_samples, "Log Cascade Memory Resource", gen);
+    test_dynamic_ds<AdaptiveSampler>(weights, mod_weights, samples, mod_samples, "Adaptive", gen);
+    test_dynamic_ds<Adaptive<AdaptiveSampler::Backend::LogCascade>>(weights, mod_weights, samples, mod_samples, "Adaptive From Log Cascade", gen);
+    test_dynamic_ds<Adaptive<AdaptiveSampler::Backend::Tree>>(weights, mod_weights, samples, mod_samples, "Adaptive From Tree", gen);
+    test_push_pop<DynamicProposalArray<>>(weights, samples, "Dynamic PA Push Pop", gen);
+    test_push_pop<DynamicProposalArrayStar<>>(weights, samples, "Dynamic PA* Push Pop", gen);
+    test_without_replacement<DynamicProposalArray<>>(weights, samples, "Dynamic PA Without Replacement", gen);
+    test_without_replacement<DynamicProposalArrayStar<>>(weights, samples, "Dynamic PA* Without Replacement", gen);
+    test_without_replacement<BinaryTree<>>(weights, samples, "Binary Tree Without Replacement", gen);
+    test_without_replacement<Float<BinaryTree<4, float>>>(weights, samples, "4-ary Tree Float Without Replacement", gen);
 
     return 0;
 }